@@ -10,6 +10,7 @@ IRQ\num:
 
 common_irq:
     pusha /* pushes all general-purpose registers */
+    cld   /* string ops in the kernel count on DF being clear */
 
     xorl %eax, %eax
     movw %ds, %ax
@@ -17,6 +17,7 @@ ISR\num:
 
 isr_common:
     pusha /* pushes all general-purpose registers */
+    cld   /* string ops in the kernel count on DF being clear */
     
     xorl %eax, %eax
     movw %ds, %ax
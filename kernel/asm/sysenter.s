@@ -0,0 +1,69 @@
+.section .text
+
+/**
+ * fast syscall entry, SYSENTER_ESP points at the tss so
+ *  the kernel stack of the running process is one load away
+ *
+ * sysenter doesn't save the return address or the user stack,
+ *  so the caller leaves them on its stack and passes the stack
+ *  in ebp (which is why the 6th argument goes there too):
+ *
+ *      pushl $1f
+ *      pushl %ebp          (6th argument)
+ *      movl  %esp, %ebp
+ *      sysenter
+ *  1:  popl  %ebp
+ *      addl  $4, %esp
+ *
+ *  ecx and edx are clobbered, everything else is as with int 0x80
+ *
+ * the frame is still laid out as a registers_t, so exec/exit
+ *  (which resume processes through isr_return) don't care how
+ *  the syscall came in, what is skipped is the segment reloads
+ *  and ISR_handler
+ */
+
+.extern ISR_syscall_handler
+.extern sys_exit
+
+.global sysenter_entry
+sysenter_entry:
+    movl 4(%esp), %esp /* tss.esp0 */
+
+    /* the kernel reads the caller's stack, make sure it is the caller's */
+    cmpl $0xC0000000 - 8, %ebp
+    jae sysenter_bad_stack
+
+    pushl $0x23        /* ss */
+    pushl %ebp         /* esp */
+    pushl $0x202       /* eflags */
+    pushl $0x1B        /* cs */
+    pushl 4(%ebp)      /* eip */
+    pushl $0           /* error code */
+    pushl $0x80        /* int_num */
+
+    movl (%ebp), %ebp  /* the 6th argument */
+    pusha
+    cld
+
+    /* the user data segment is flat, the kernel runs on it as is */
+    pushl $0x23
+
+    pushl %esp
+    call ISR_syscall_handler
+    addl $4, %esp
+
+    addl $4, %esp      /* ds */
+    popa
+    addl $8, %esp      /* int_num and error code */
+
+    movl (%esp), %edx   /* eip */
+    movl 12(%esp), %ecx /* esp */
+
+    /* sti holds interrupts off for one more instruction */
+    sti
+    sysexit
+
+sysenter_bad_stack:
+    pushl $-1
+    call sys_exit
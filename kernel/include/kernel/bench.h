@@ -0,0 +1,19 @@
+#ifndef _BENCH_H
+#define _BENCH_H
+
+/**
+ * boot time microbenchmarks, only built with BENCH=1
+ */
+
+#ifdef BENCH
+
+/**
+ * prints tsc cycles per call of the rep movsd/stosd and
+ *  sse2 memcpy/memset at sizes 16B..64KiB, and the smallest
+ *  size where sse2 won (the MEM_SSE2_*_MIN crossovers)
+ */
+void BENCH_mem();
+
+#endif
+
+#endif
@@ -15,11 +15,26 @@ struct t_DeviceFile {
     size_t (*f_write)
         (const void *buff, size_t bytes);
 
+    /**
+     * optional, for devices that read like a file, gets the
+     *  position of the open file and is used instead of f_read
+     */
+    size_t (*f_read_at)
+        (void *buff, size_t bytes, size_t pos);
+
     t_DeviceFile *next;
 };
 
 extern t_VFSOperations dev_vfs_ops;
 
+/**
+ * adds a copy of file to DEV, name has to be
+ *  allocated (it is freed on removal)
+ */
+t_DeviceFile *DEV_add_file(t_DeviceFile *file);
+
+void DEV_remove_file(t_DeviceFile *file);
+
 t_FSContext DEV_init();
 
 void DEV_uninit();
@@ -28,9 +43,13 @@ t_FSNode DEV_root();
 
 t_DeviceFile *DEV_lookup(t_FSNode parent, const char *name);
 
-size_t DEV_read(t_FSNode *file, size_t bytes, void *buff);
+t_FSFile DEV_open(t_FSNode *file, uint8_t mode);
+
+void DEV_close(t_FSFile file);
+
+size_t DEV_read(t_FSFile file, size_t bytes, void *buff);
 
-size_t DEV_write(t_FSNode *file, size_t bytes, const void *buff);
+size_t DEV_write(t_FSFile file, size_t bytes, const void *buff);
 
 t_DeviceFile *DEV_readdir(t_FSNode dir, size_t n);
 
@@ -133,6 +133,25 @@ void DMA_reset(uint8_t dma);
 
 void DMA_unmask_all();
 
+/* 8 bit channels move at most 64KiB and can't cross a 64KiB boundary */
+#define DMA_MAX_TRANSFER 0x10000
+/* the dma pool gets mapped into the device driver area */
+#define DMA_POOL_VADDR   0xE0000000
+
+/**
+ * hands out physically contiguous buffers from the pool below 16MiB,
+ * a buffer never crosses a 64KiB boundary so it can be used for one transfer
+ */
+void *DMA_alloc(size_t len, uint32_t *out_paddr);
+void  DMA_free (void *buff, size_t len);
+
+/**
+ * programs channel for a transfer of len bytes at paddr, mode is a combination
+ * of DMA_MODE_*_TRANSFER, DMA_MODE_TRANSFER_* and optionally DMA_MODE_MASK_AUTO
+ * for auto-init. returns -1 if the buffer can't be reached by the channel
+ */
+int DMA_setup_transfer(uint8_t channel, uint32_t paddr, size_t len, uint8_t mode);
+
 #define DMA_SET_READ(channel) \
     DMA_set_mode(channel, DMA_MODE_READ_TRANSFER | DMA_MODE_TRANSFER_SINGLE | DMA_MODE_MASK_AUTO)
 
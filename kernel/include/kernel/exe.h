@@ -4,6 +4,8 @@
 #include <kernel/kmm.h>
 #include <kernel/isr.h>
 #include <kernel/umm.h>
+#include <kernel/vfs.h>
+#include <kernel/ring.h>
 
 #ifndef __EXE_H
 #define __EXE_H
@@ -15,6 +17,9 @@ struct t_Process {
     void *kernel_stack;
     pdirectory_t *address_space;
     umm_block_t *blocks;
+    t_FDTable fds;
+    /* the submission ring, NULL until ring_setup */
+    t_Ring *ring;
     t_Process *prev;
 };
 
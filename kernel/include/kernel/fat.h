@@ -279,6 +279,13 @@ typedef struct {
     uint32_t trail_signature;
 } __attribute__((__packed__)) t_FAT32_FSInfo;
 
+#define FAT_CLUSTER_USED(ctx, cluster) \
+    ((ctx)->free_map[(cluster) / 32] & (1u << ((cluster) % 32)))
+
+#define FAT_FSINFO_LEAD_SIG  0x41615252
+#define FAT_FSINFO_STRUC_SIG 0x61417272
+#define FAT_FSINFO_TRAIL_SIG 0xAA550000
+
 typedef enum {
     FAT_NULL,
     FAT_12,
@@ -288,6 +295,35 @@ typedef enum {
 
 typedef struct t_FATHandle t_FATHandle;
 typedef struct t_FATContext t_FATContext;
+typedef struct t_FATDirSlot t_FATDirSlot;
+typedef struct t_FATDirIndex t_FATDirIndex;
+
+struct t_FATDirSlot {
+    uint8_t       name[11];
+    uint32_t      entry_num,
+                  cluster;
+    t_FATDirSlot *next;
+};
+
+#define FAT_DIR_BUCKETS     32
+#define FAT_MAX_DIR_INDEXES 16
+
+/**
+ * hashed index over the short entries of a directory
+ *  num_entries: entries in use up to the end of directory marker
+ *  capacity:    fixed size of the FAT12/16 root, -1 otherwise
+ *  free_slots:  deleted entries that can be reused
+ */
+struct t_FATDirIndex {
+    uint32_t       dir_cluster,
+                   num_entries,
+                   capacity;
+    uint32_t      *free_slots;
+    uint32_t       num_free,
+                   cap_free;
+    t_FATDirSlot  *buckets[FAT_DIR_BUCKETS];
+    t_FATDirIndex *next;
+};
 
 struct t_FATHandle {
     uint32_t dir_cluster,
@@ -331,6 +367,33 @@ struct t_FATContext {
      */
     uint32_t              bytes_p_clus;
 
+    /**
+     * in-memory copy of the first FAT, all the copies
+     *  on disk are updated from it by FAT_flush
+     * fat_dirty has one bit per FAT sector
+     */
+    uint8_t              *fat;
+    uint8_t              *fat_dirty;
+    size_t                fat_size;
+    uint32_t              fat_sectors;
+
+    /* number of data clusters, valid cluster numbers are [2, num_clusters + 2) */
+    uint32_t              num_clusters;
+
+    /**
+     * free cluster bitmap (set = in use) built at mount,
+     *  next_free is where the next search for a free
+     *  cluster starts and is stored in FSInfo on FAT32
+     */
+    uint32_t             *free_map;
+    uint32_t              free_count;
+    uint32_t              next_free;
+    bool                  fsinfo_valid;
+    bool                  fsinfo_dirty;
+
+    /* directory indexes, most recently used first */
+    t_FATDirIndex        *dir_indexes;
+
     t_FATHandle root;
 };
 
@@ -567,6 +630,10 @@ typedef enum {
     DIR_ENTRY_VOL_LABEL,
 } e_LongDirEntryType;
 
+uint32_t FAT_get_entry(t_FATContext *context, uint8_t fat_num, uint32_t cluster);
+
+uint32_t FAT_set_entry(t_FATContext *context, uint8_t fat_num, uint32_t cluster, uint32_t data);
+
 uint32_t FAT_absolute_offset(t_FATContext *ctx, uint32_t cluster, size_t offset, uint32_t *clus_fail);
 
 uint32_t FAT_dir_entry(t_FATContext *ctx, uint32_t cluster, uint32_t entry_num, void *out_entry);
@@ -575,6 +642,12 @@ size_t FAT_clus_to_off(t_FATContext *ctx, uint32_t cluster);
 
 uint32_t FAT_find_file(t_FATContext *ctx, uint32_t cluster, const char *name);
 
+/**
+ * same as FAT_find_file but name is len bytes
+ *  and doesn't need to be null terminated
+ */
+uint32_t FAT_find_file_n(t_FATContext *ctx, uint32_t cluster, const char *name, size_t len);
+
 uint32_t FAT_file_cluster(t_FATContext *ctx, const char *_path);
 
 /**
@@ -594,22 +667,65 @@ void FAT_write_entry(t_FATContext *ctx, uint32_t cluster, void *entry);
 
 void FAT_conv_fname(const char *name, char *out);
 
+void FAT_conv_fname_n(const char *name, size_t len, char *out);
+
 void FAT_init_dir(t_FATContext *ctx, uint32_t cluster, uint32_t parent_clus);
 
-void FAT_allocate_cluster(t_FATContext *ctx, uint32_t cluster);
+t_FATDirIndex *FAT_dir_index(t_FATContext *ctx, uint32_t dir_cluster);
+
+uint32_t FAT_allocate_cluster(t_FATContext *ctx, uint32_t cluster);
+
+void FAT_flush(t_FATContext *ctx);
 
 
+/* a run of len clusters, contiguous both in the file and on disk */
+typedef struct {
+    uint32_t file_clus,
+             disk_clus,
+             len;
+} t_FATExtent;
+
 typedef struct {
     uint32_t starting_clus,
              parent_clus,
              position;
+    /* number of the entry in the parent directory */
+    uint32_t dir_entry;
     size_t   size; 
     /* refer to e_FATFileFlagMasks */
     uint8_t flags;
 
+    /**
+     * read-ahead state
+     *  ra_next:   where the next read starts if the file is read sequentially
+     *  ra_end:    everything before this offset is already prefetched
+     *  ra_window: clusters prefetched ahead, 0 while access is random
+     */
+    uint32_t ra_next,
+             ra_end,
+             ra_window;
+
+    /* cluster chain as runs sorted by file_clus, built on first use */
+    t_FATExtent *extents;
+    uint32_t     num_extents,
+                 cap_extents;
+    bool         extents_built;
+
+    /* length of the chain and its last cluster, valid once the map is built */
+    uint32_t     num_clus,
+                 tail_clus;
+
     t_FATContext *ctx;
 } t_FATFile;
 
+size_t FAT_file_offset(t_FATFile *file, size_t position, size_t *out_contig);
+
+int FAT_fallocate(t_FATFile *file, size_t offset, size_t len);
+
+/* the read-ahead window starts at MIN clusters and doubles up to MAX */
+#define FAT_READAHEAD_MIN 2
+#define FAT_READAHEAD_MAX 16
+
 #define BYTES_PER_CLUSTER(ctx)\
     ((ctx)->boot_sector.bytes_per_sector * (ctx)->boot_sector.sectors_per_cluster)
 
@@ -679,12 +795,26 @@ void FAT_close(t_FATFile *file);
 
 size_t FAT_write(t_FATFile *file, size_t len, void *data);
 
+/**
+ * grows the file to size, the clusters are reserved as one
+ *  run and zeroed in large device writes
+ */
+size_t FAT_extend(t_FATFile *file, size_t size);
+
+/**
+ * writes every buffer of the iovec with a single cluster
+ *  reservation for the whole request
+ */
+size_t FAT_writev(t_FATFile *file, const t_IOVec *iov, int iovcnt);
+
 size_t FAT_read(t_FATFile *file, size_t len, void *data);
 
 t_FATHandle *FAT_read_dir(t_FATHandle *dir, size_t n);
 
 const char *FAT_handle_name(t_FATHandle *handle);
 
+void FAT_release(t_FATHandle *handle);
+
 void FAT_file_stat(t_FATHandle *file, t_FileStat *out);
 
 size_t FAT_file_seek(t_FATFile *file, size_t position);
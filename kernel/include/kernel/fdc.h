@@ -12,24 +12,44 @@ void IRQ_FDC_handler();
 
 void FDC_read_sector(storage_device_t *device, void *buff, uint32_t lba);
 void FDC_write_sector(storage_device_t *device, const void *buff, uint32_t lba);
+int FDC_flush(storage_device_t *device);
 void FDC_set_drive(uint8_t drive);
 #define FLOPPY_BYTES_PER_SECTOR 512
 static void FDC_write_cmd(uint8_t command);
-static void FDC_DMA_init();
+static void FDC_DMA_init(bool write, size_t offset, size_t len);
 static uint8_t FDC_read_data();
 static void FDC_check_int(uint8_t *st0, uint8_t *cylinder);
 static void FDC_start_motor(uint8_t drive);
 static void FDC_stop_motor();
+static void FDC_schedule_motor_off();
+static void FDC_motor_tick(uint64_t ticks);
 static void FDC_disable();
 static void FDC_enable();
 static void FDC_irq_wait();
 static void FDC_CMD_specify(uint32_t stepr, uint32_t loadt, uint32_t unloadt, bool dma);
 static int FDC_CMD_callibrate(uint8_t drive);
 static int FDC_CMD_seek(uint8_t cyl, uint8_t head);
+static int FDC_CMD_transfer(bool write, uint8_t head, uint8_t cylinder,
+                            uint8_t sector, uint8_t eot, size_t offset,
+                            size_t len);
+static int FDC_read_cylinder(uint8_t drive, uint8_t cylinder);
+static int FDC_flush_track();
 
 #define FLOPPY_CHANNEL 2
 #define FLOPPY_IRQ 6
 #define FLOPPY_SECTORS_PER_TRACK 18
+#define FLOPPY_HEADS 2
+#define FLOPPY_SECTORS_PER_CYLINDER (FLOPPY_SECTORS_PER_TRACK * FLOPPY_HEADS)
+#define FLOPPY_BYTES_PER_CYLINDER (FLOPPY_SECTORS_PER_CYLINDER * FLOPPY_BYTES_PER_SECTOR)
+
+/* ms of idling before the motor is turned off */
+#define FDC_MOTOR_TIMEOUT_MS 2000
+#define FDC_RETRIES 3
+
+/* interrupt code of ST0, 00 = normal termination */
+#define FDC_ST0_IC_MASK 0xC0
+/* ST1 EN, the transfer ran past the last sector of the cylinder */
+#define FDC_ST1_END_OF_CYLINDER 0x80
 
 /**
  * FDC REGISTERS
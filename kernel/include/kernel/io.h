@@ -17,6 +17,30 @@ uint32_t port_read_long(uint16_t port);
 void port_write_slow_byte(uint16_t port, uint8_t data);
 
 void io_wait();
+
+/**
+ * model specific registers
+ */
+typedef enum {
+    MSR_SYSENTER_CS  = 0x174,
+    MSR_SYSENTER_ESP = 0x175,
+    MSR_SYSENTER_EIP = 0x176,
+} e_MSR;
+
+uint64_t msr_read(uint32_t msr);
+void     msr_write(uint32_t msr, uint64_t value);
+
+/* feature bits of cpuid leaf 1 */
+typedef enum {
+    CPUID_FEAT_EDX_TSC = 1 << 4,
+    CPUID_FEAT_EDX_MSR = 1 << 5,
+    CPUID_FEAT_EDX_SEP = 1 << 11,
+} e_CPUID_FEAT;
+
+void cpu_id(uint32_t leaf, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx);
+
+/* the time stamp counter, check CPUID_FEAT_EDX_TSC first */
+uint64_t cpu_tsc();
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,79 @@
+#ifndef _PGC_H
+#define _PGC_H
+
+#include "../../libc/include/types.h"
+#include "vfs.h"
+
+/**
+ * the page cache holds file data in whole page frames keyed by
+ *  (vnode, page index), reads and writes through the VFS go
+ *  through it and file mappings map its frames directly
+ */
+
+/* frames are set aside and mapped into the kernel window at init */
+#define PGC_PAGES   256
+#define PGC_BUCKETS 64
+#define PGC_VADDR   0xE0400000
+
+typedef struct t_PGCPage t_PGCPage;
+
+struct t_PGCPage {
+    t_VFSNode *vnode;
+    uint32_t   index;
+    /* bytes of file data in the page, the rest is zeroed */
+    uint32_t   valid;
+    /* user mappings of the frame, mapped pages are never evicted */
+    uint32_t   maps;
+    void      *data;
+    void      *paddr;
+    t_PGCPage *hash_next,
+              *lru_prev,
+              *lru_next;
+};
+
+void PGC_init();
+
+/**
+ * reads len bytes at pos of the open file through the cache,
+ *  returns the number of bytes read (short at end of file)
+ */
+size_t PGC_read(t_FileDescriptor *file, size_t pos, size_t len, void *buff);
+
+/**
+ * copies data that was just written through the driver into
+ *  the pages of vnode that are cached, pages that aren't
+ *  cached are left alone
+ */
+void PGC_update(t_VFSNode *vnode, size_t pos, size_t len, const void *buff);
+
+/**
+ * the file grew to size with zeroes, cached pages
+ *  already hold zeroes past their data so they just
+ *  take the new length
+ */
+void PGC_extend(t_VFSNode *vnode, size_t size);
+
+/**
+ * drops every unmapped page of vnode
+ */
+void PGC_invalidate(t_VFSNode *vnode);
+
+/**
+ * returns the cached page of the file, NULL if it isn't cached
+ */
+t_PGCPage *PGC_find(t_FileDescriptor *file, uint32_t index);
+
+/**
+ * returns the page at index of the open file, filled and
+ *  pinned for a user mapping until PGC_unmap,
+ *  NULL if every page in the cache is mapped
+ */
+t_PGCPage *PGC_map(t_FileDescriptor *file, uint32_t index);
+void       PGC_unmap(t_PGCPage *page);
+
+/**
+ * writes the valid part of the page back through the driver
+ */
+void PGC_writeback(t_PGCPage *page, t_FileDescriptor *file);
+
+#endif
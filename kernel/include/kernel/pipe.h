@@ -0,0 +1,62 @@
+#ifndef _PIPE_H
+#define _PIPE_H
+
+#include "../../libc/include/types.h"
+#include "vfs.h"
+
+/* must be a power of two, indices are masked into the ring */
+#define PIPE_SIZE 0x1000
+
+/**
+ * tasks waiting on a pipe end, until there is a scheduler
+ *  a waiter halts until the next interrupt and checks again
+ */
+typedef struct {
+    volatile uint32_t waiters;
+} t_WaitQueue;
+
+/**
+ * single producer/single consumer ring, head is only moved
+ *  by the writer and tail only by the reader, both run
+ *  freely and wrap through the mask
+ */
+typedef struct {
+    uint8_t  buff[PIPE_SIZE];
+    uint32_t head,
+             tail;
+    /* open ends, a pipe is freed with its last end */
+    uint32_t readers,
+             writers;
+    t_WaitQueue read_queue,
+                write_queue;
+} t_Pipe;
+
+typedef struct {
+    t_Pipe *pipe;
+    bool    write;
+} t_PipeEnd;
+
+extern t_VFSOperations pipe_vfs_ops;
+
+/**
+ * makes a new pipe and its two ends, -1 on failure
+ */
+int PIPE_create(t_PipeEnd **out_read, t_PipeEnd **out_write);
+
+/**
+ * blocks until there is data or every writer is gone,
+ *  returns 0 at end of file
+ */
+size_t PIPE_read(t_PipeEnd *end, size_t bytes, void *buff);
+
+/**
+ * blocks until everything is written, returns short
+ *  (or -1 if nothing was written) once every reader is gone
+ */
+size_t PIPE_write(t_PipeEnd *end, size_t bytes, const void *buff);
+
+void PIPE_close(t_PipeEnd *end);
+
+void PIPE_fstat(t_PipeEnd *end, t_FileStat *out);
+
+#endif
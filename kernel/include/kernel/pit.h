@@ -5,6 +5,8 @@
 #include "idt.h"
 #include "irq.h"
 
+typedef void (*PIT_tick_handler_t)(uint64_t ticks);
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -12,6 +14,8 @@ void PIT_set_freq(int hz);
 void IRQ_time_handler();
 void PIT_init();
 void PIT_sleep(uint64_t ms);
+int PIT_add_tick_handler(PIT_tick_handler_t handler);
+uint64_t PIT_ticks();
 #ifdef __cplusplus
 }
 #endif
@@ -12,6 +12,14 @@
 #define BITMAP_BLOCK_FREE 0x0
 #define BITMAP_BLOCK_USED 0x1
 
+/**
+ * isa dma can only reach the first 16MiB, so a physically contiguous pool
+ * is set aside there at init (aligned so its 64KiB banks line up)
+ */
+#define PMM_DMA_ZONE_END   0x1000000
+#define PMM_DMA_POOL_SIZE  0x20000
+#define PMM_DMA_POOL_ALIGN 0x10000
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -24,6 +32,9 @@ void free_page(void* page);
 void* alloc_pages(size_t n);
 void free_pages(void* page, size_t n);
 
+/* physical address of the dma pool, NULL if it couldnt be reserved */
+void* PMM_dma_pool();
+
 #ifdef __cplusplus
 }
 #endif
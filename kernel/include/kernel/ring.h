@@ -0,0 +1,69 @@
+#ifndef _RING_H
+#define _RING_H
+
+#include "../../libc/include/types.h"
+
+/**
+ * a submission/completion ring shared with a process, it
+ *  queues file operations in the submission queue and has
+ *  the kernel run the whole batch with one ring_enter,
+ *  results come back in the completion queue
+ */
+
+/* entries per queue, must be a power of two */
+#define RING_ENTRIES 64
+
+/**
+ * opcode is the syscall number of the operation, only
+ *  read, write, open, close, lseek, pread and pwrite are
+ *  accepted, args are its arguments in register order
+ */
+typedef struct {
+    uint32_t opcode;
+    uint32_t args[4];
+    /* handed back untouched in the completion */
+    uint32_t user_data;
+} t_RingSubmission;
+
+typedef struct {
+    uint32_t user_data;
+    /* what the syscall returned, -1 for a bad opcode */
+    uint32_t res;
+} t_RingCompletion;
+
+/**
+ * the indices run freely and wrap through the mask, the
+ *  process moves sq_tail and cq_head and the kernel moves
+ *  sq_head and cq_tail
+ */
+typedef struct t_Ring {
+    uint32_t sq_head,
+             sq_tail,
+             cq_head,
+             cq_tail;
+    uint32_t entries;
+    t_RingSubmission sq[RING_ENTRIES];
+    t_RingCompletion cq[RING_ENTRIES];
+} t_Ring;
+
+/* what the ring takes in the address space, whole pages */
+#define RING_SIZE ((sizeof(t_Ring) + 0xFFF) & ~0xFFFU)
+
+typedef struct t_Process t_Process;
+
+/**
+ * maps the ring of process into its address space (once,
+ *  later calls return the same ring until it is unmapped),
+ *  NULL if there is no room
+ */
+t_Ring *RING_setup(t_Process *process);
+
+/**
+ * runs up to count queued submissions of process in order,
+ *  stops early when the completion queue is full
+ * returns the number of submissions consumed, -1 if the
+ *  process has no ring (or unmapped it)
+ */
+int RING_enter(t_Process *process, uint32_t count);
+
+#endif
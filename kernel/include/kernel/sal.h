@@ -7,6 +7,7 @@ typedef struct storage_device_t storage_device_t;
 
 typedef void    (*f_ReadSector )(storage_device_t *device, void *buff, uint32_t lba);
 typedef void    (*f_WriteSector)(storage_device_t *device, const void *buff, uint32_t lba);
+typedef int     (*f_Flush      )(storage_device_t *device);
 
 struct storage_device_t {
     uint32_t      maxlba;
@@ -15,6 +16,8 @@ struct storage_device_t {
     uint8_t       drive_num;
     f_ReadSector  read_sector;
     f_WriteSector write_sector;
+    /* optional, pushes out anything the driver is holding back */
+    f_Flush       flush;
     /* can be used by other applications for extra data */
     void         *extra;
 };
@@ -30,6 +33,19 @@ struct storage_device_t {
 
 void SAL_write(storage_device_t *device, size_t len, uint32_t offset, void *buff);
 void SAL_read (storage_device_t *device, size_t len, uint32_t offset, void *buff);
+int  SAL_sync (storage_device_t *device);
+
+/**
+ * pulls the sectors covering [offset, offset + len) into the block cache
+ *  so later reads of them dont have to touch the device
+ */
+void SAL_prefetch(storage_device_t *device, size_t len, uint32_t offset);
+
+/**
+ * the most sectors a prefetch should pull in, half the block cache,
+ *  callers that prefetch in pieces keep the whole batch under it
+ */
+#define SAL_PREFETCH_MAX 64
 
 void SAL_add_device(storage_device_t device);
 storage_device_t *SAL_get_devices(uint32_t *out_num_devices);
@@ -37,3 +53,15 @@ storage_device_t *SAL_get_devices(uint32_t *out_num_devices);
 void SAL_init();
 
 #endif
+
+#ifdef _SAL_H_INTERNAL
+
+/* devices with bigger sectors bypass the block cache */
+#define SAL_CACHE_SECTOR_SIZE 512
+/* twice SAL_PREFETCH_MAX */
+#define SAL_CACHE_BLOCKS      128
+#define SAL_CACHE_BUCKETS     64
+/* how often dirty sectors are pushed out if nobody calls SAL_sync */
+#define SAL_WRITEBACK_INTERVAL_MS 5000
+
+#endif
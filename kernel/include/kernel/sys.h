@@ -18,6 +18,10 @@
  *  [4] esi
  *  [5] edi
  *  [6] ebp
+ *
+ * syscalls come in through int 0x80 or sysenter,
+ *  see kernel/asm/sysenter.s for the sysenter
+ *  calling sequence
  */
 
 typedef enum {
@@ -30,8 +34,19 @@ typedef enum {
     SYSCALL_LSEEK  = 8,
     SYSCALL_MMAP   = 9,
     SYSCALL_MUNMAP = 11,
+    SYSCALL_PREAD  = 17,
+    SYSCALL_PWRITE = 18,
+    SYSCALL_READV  = 19,
+    SYSCALL_WRITEV = 20,
+    SYSCALL_PIPE   = 22,
+    SYSCALL_MSYNC  = 26,
     SYSCALL_EXEC   = 59,
-    SYSCALL_EXIT   = 60
+    SYSCALL_EXIT   = 60,
+
+    SYSCALL_RING_SETUP = 425,
+    SYSCALL_RING_ENTER = 426,
+
+    SYSCALL_MAX
 } e_SYSCALL_NUMS;
 
 typedef enum {
@@ -65,8 +80,40 @@ typedef enum {
     SYSCALL_MMAP_FLAG_GROWSDOWN = 0x0100,
 } e_SYSCALL_MMAP_FLAG;
 
+typedef enum {
+    SYSCALL_MSYNC_ASYNC      = 0x1,
+    SYSCALL_MSYNC_INVALIDATE = 0x2,
+    SYSCALL_MSYNC_SYNC       = 0x4,
+} e_SYSCALL_MSYNC_FLAG;
+
 void ISR_syscall_handler(registers_t *regs);
 
+/**
+ * runs syscall num with its arguments in register order
+ *  and accounts for it, -1 for unknown syscalls
+ */
+uint32_t SYS_dispatch(
+    uint32_t num, 
+    uint32_t a, uint32_t b, uint32_t c, 
+    uint32_t d, uint32_t e, uint32_t f
+);
+
+/**
+ * sets up the sysenter entry point if the cpu has one
+ */
+void SYS_init();
+
+/**
+ * the DEV/SYSCALLS file, reading it gives a line per
+ *  syscall: name, calls, errors, total tsc cycles and a
+ *  latency histogram (the first bucket is under 256
+ *  cycles, each next one doubles, the last takes the rest)
+ * every open reads it from the start to the end (where
+ *  reads return 0), writing anything to it resets the counters
+ */
+size_t SYS_stats_read(void *buff, size_t bytes, size_t pos);
+size_t SYS_stats_reset(const void *buff, size_t bytes);
+
 size_t sys_read(int fd, void *buff, size_t count);
 size_t sys_write(int fd, const void *buff, size_t count);
 
@@ -78,8 +125,26 @@ int sys_fstat(int fd, t_FileStat *statbuff);
 
 size_t sys_lseek(int fd, ssize_t offset, int whence);
 
+size_t sys_pread(int fd, void *buff, size_t count, size_t offset);
+size_t sys_pwrite(int fd, const void *buff, size_t count, size_t offset);
+
+size_t sys_readv(int fd, const t_IOVec *iov, int iovcnt);
+size_t sys_writev(int fd, const t_IOVec *iov, int iovcnt);
+
+/* fds[0] is the read end, fds[1] the write end */
+int sys_pipe(int *fds);
+
 void *sys_mmap(void *addr, size_t length, int prot, int flags, int fd, size_t offset);
 int   sys_munmap(void *addr, size_t length);
+int   sys_msync(void *addr, size_t length, int flags);
+
+/**
+ * maps the submission/completion ring (see kernel/ring.h)
+ *  and returns it, ring_enter runs count queued submissions
+ *  and returns how many it took
+ */
+void *sys_ring_setup();
+int   sys_ring_enter(uint32_t count);
 
 int  sys_exec(const char *path, int argc, char **argv); 
 void sys_exit(int status);
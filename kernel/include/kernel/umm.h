@@ -6,10 +6,14 @@
 typedef struct umm_block_t umm_block_t;
 /* don't want cyclical includes */
 typedef struct t_Process t_Process;
+typedef struct t_FileDescriptor t_FileDescriptor;
 
 /**
  * allocates len memory within user memory space
  *  for specified process.
+ * the pages are zeroed before they are mapped, the kernel
+ *  can't clear them afterwards since read-only ones fault
+ *  with CR0.WP set
  * assumes:
  *  len % 0x1000 == 0
  */
@@ -19,7 +23,7 @@ void *ualloc_pages(
 
 /**
  * allocates len memory within user memory space
- *  starting at vaddr
+ *  starting at vaddr, zeroed like ualloc_pages
  * assumes:
  *  vaddr % 0x1000 == 0
  *  len % 0x1000 == 0
@@ -27,11 +31,57 @@ void *ualloc_pages(
  */
 void umap_pages(t_Process *process, void *vaddr, size_t len, int prot, int flags);
 
+/**
+ * maps len bytes of file starting at offset to vaddr, the
+ *  pages are frames of the page cache mapped in on the
+ *  first fault: shared mappings write to them directly, 
+ *  private ones copy on write
+ * the block takes over the caller's reference to file
+ * assumes the same as umap_pages and offset % 0x1000 == 0
+ */
+void umap_file_pages(
+    t_Process *process, void *vaddr, size_t len, int prot, int flags,
+    t_FileDescriptor *file, size_t offset
+);
+
+/**
+ * same as ualloc_pages but the pages come from file,
+ *  takes over the reference to file like umap_file_pages
+ */
+void *ualloc_file_pages(
+    t_Process *process, size_t len, int prot, int flags,
+    t_FileDescriptor *file, size_t offset
+);
+
+/**
+ * writes the pages of shared file mappings in the range
+ *  that were written to back to their files
+ */
+void umm_sync_range(t_Process *process, void *vaddr, size_t len);
+
+/**
+ * unmaps every file mapping of the process, so the
+ *  cache frames are handed back before the process
+ *  frees its pages
+ */
+void umm_unmap_files(t_Process *process);
+
 /**
  * unmaps the block starting at vaddr 
  */
 void umm_unmap_pages(t_Process *process, void *vaddr);
 
+/**
+ * whether [vaddr, vaddr + len) lies where mappings can
+ *  go, it stops short of the vdso page and the stack
+ */
+int umm_user_range(void *vaddr, size_t len);
+
+/**
+ * the block addr falls in, NULL if it isn't mapped
+ */
+umm_block_t *umm_find_block(t_Process *process, void *addr);
+
 void umm_page_flt_handler(void *fault_addr);
 
 void umm_unmap_range(t_Process *process, void *vaddr, size_t len);
@@ -41,6 +91,10 @@ struct umm_block_t {
     size_t len;
     int prot;
     int flags;
+    /* NULL for anonymous memory */
+    t_FileDescriptor *file;
+    /* file offset of start */
+    size_t offset;
     struct umm_block_t *next;
 };
 
@@ -0,0 +1,50 @@
+#ifndef _VDSO_H
+#define _VDSO_H
+
+#include "../../libc/include/types.h"
+#include "rtc.h"
+
+/**
+ * a page the kernel keeps the time in, mapped read only
+ *  into every process so reading the time needs no syscall
+ */
+
+/* where processes see it, below the initial stack */
+#define VDSO_VADDR  0xBF000000
+/* where the kernel writes it, after the page cache window */
+#define VDSO_KVADDR 0xE0500000
+
+typedef struct {
+    /* ms since boot, the PIT runs at 1000Hz */
+    uint64_t  ticks;
+    /* wall clock, second resolution */
+    t_RTCTime time;
+    /* the tsc at the last tick, and tsc cycles per tick (0 without a tsc) */
+    uint64_t  tsc;
+    uint32_t  tsc_per_tick;
+} t_VDSOTime;
+
+/**
+ * seq is odd while the kernel is writing, readers copy
+ *  data and retry until seq was even and didn't change
+ */
+typedef struct {
+    volatile uint32_t seq;
+    t_VDSOTime data;
+} t_VDSOPage;
+
+void VDSO_init();
+
+/**
+ * publishes the tick (and the wall clock), called
+ *  from the timer irq
+ */
+void VDSO_update(uint64_t ticks);
+
+/**
+ * maps/unmaps the page in the current address space
+ */
+void VDSO_map();
+void VDSO_unmap();
+
+#endif
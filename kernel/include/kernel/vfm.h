@@ -3,11 +3,30 @@
 
 #ifdef _VFM_H_INTERNAL
 
+#define VFM_CHUNK_SIZE 512
+
+/**
+ * file data lives in a list of fixed size chunks, each
+ *  using data[start, end) so both ends can grow in place
+ */
+typedef struct t_VFMChunk {
+    struct t_VFMChunk *next,
+                      *prev;
+    uint16_t start,
+             end;
+    char data[VFM_CHUNK_SIZE];
+} t_VFMChunk;
+
 typedef struct t_VFMFile {
     t_FileChrono modified;
     struct t_VFMFile *next;
-    char *content,
-         *name;
+    char *name;
+    t_VFMChunk *head,
+               *tail;
+    size_t size;
+    /* chunk last used for pos and the offset of its first byte */
+    t_VFMChunk *pos_chunk;
+    size_t pos_base;
     size_t pos;
     uint8_t opflags,  // 0 == closed 
             fileflags;
@@ -106,7 +125,7 @@ size_t VFM_write(t_VFMFile *file, size_t bytes, const void *buff);
 /**
  * instead of appending data to the virtual
  *  file buffer, this function pushes data
- *  to the back of the buffer, acting as a
+ *  to the front of the buffer, acting as a
  *  queue pusher
  */
 size_t VFM_writeback(t_VFMFile *file, size_t bytes, const void *buff);
@@ -123,10 +142,16 @@ const char *VFM_nodename(t_VFMHandle *file);
  */
 void VFM_fstat(t_VFMHandle *file, t_FileStat *out);
 
+/**
+ * grows the file to size with zeroes
+ */
+size_t VFM_extend(t_VFMFile *file, size_t size);
+
 /**
  * sets the position of the file
  *  assumes it is within the bounds of the file
+ * (-1) leaves it alone, returns the position
  */
-void VFM_seek(t_VFMFile *file, size_t position);
+size_t VFM_seek(t_VFMFile *file, size_t position);
 
 #endif
@@ -41,6 +41,14 @@ typedef void
      */
     *t_FSFile;
 
+/**
+ * one buffer of a scatter/gather request
+ */
+typedef struct {
+    void  *base;
+    size_t len;
+} t_IOVec;
+
 typedef struct {
     uint16_t year;
     uint8_t  seconds,
@@ -155,6 +163,31 @@ typedef struct {
      */
     size_t      (*f_Seek)(t_FSFile, size_t);
 
+    /**
+     * optional, grows the file to the given size
+     *  with zeroes (does nothing if it is already
+     *  that big) and returns the new size, the
+     *  VFS falls back to writing zeroes
+     */
+    size_t      (*f_Extend)(t_FSFile, size_t);
+
+    /**
+     * optional, read/write the buffers of an
+     *  iovec in order as one request, the VFS
+     *  falls back to f_Read/f_Write per buffer
+     */
+    size_t      (*f_ReadV)(t_FSFile, const t_IOVec *, int);
+    size_t      (*f_WriteV)(t_FSFile, const t_IOVec *, int);
+
+    /**
+     * optional, called when the VFS drops
+     *  a node it got from f_Lookup (e.g. when
+     *  the dentry cache evicts it), drivers
+     *  that allocate their handles free them
+     *  here
+     */
+    void        (*f_Release)(t_FSNode);
+
     /**
      * the fs driver is not responsible for
      *  managing memory of the handles returned,
@@ -171,16 +204,15 @@ typedef struct {
      */
 } t_VFSOperations;
 
+typedef struct t_VFSNode t_VFSNode;
+typedef struct t_FileDescriptor t_FileDescriptor;
+
 void VFS_init();
 
 void VFS_register_fs(t_VFSOperations *ops);
 
 void VFS_curr_chrono(t_FileChrono *out);
 
-int VFS_add_descriptor(t_FSFile file);
-
-void VFS_rem_descriptor(int fd);
-
 /**
  * VFS PUBLIC API START
  */
@@ -191,7 +223,22 @@ void VFS_close(int descriptor);
 size_t VFS_write(int descriptor, void *data, size_t len);
 size_t VFS_read(int descriptor, void *data, size_t len);
 
+/**
+ * read/write at offset without moving the file
+ *  position, -1 on files that can't seek
+ */
+size_t VFS_pwrite(int descriptor, const void *data, size_t len, size_t offset);
+size_t VFS_pread(int descriptor, void *data, size_t len, size_t offset);
+
+/**
+ * scatter/gather versions of read and write, the
+ *  buffers are filled/drained in order
+ */
+size_t VFS_writev(int descriptor, const t_IOVec *iov, int iovcnt);
+size_t VFS_readv(int descriptor, const t_IOVec *iov, int iovcnt);
+
 void VFS_create(const char *path, uint8_t attributes);
+/* does nothing while the file is open or mapped */
 void VFS_remove(const char *path);
 
 void VFS_stat(const char *path, const t_FileStat *stat);
@@ -199,6 +246,61 @@ void VFS_fstat(int descriptor, const t_FileStat *stat);
 
 size_t VFS_seek(int descriptor, ssize_t offset, int whence);
 
+/**
+ * makes a descriptor for a file that was opened outside
+ *  of the fs tree (pipes), it has no vnode
+ * returns -1 and closes file if it fails
+ */
+int VFS_open_file(t_FSFile file, t_VFSOperations *ops, uint8_t mode);
+
+/**
+ * returns the open file behind descriptor and takes a
+ *  reference to it, so it stays open after the descriptor
+ *  is closed (file mappings hold one)
+ * returns NULL if it wasn't opened with all of mode,
+ *  or isn't a file of the fs tree
+ */
+t_FileDescriptor *VFS_hold_descriptor(int descriptor, uint8_t mode);
+
+/**
+ * takes another reference to an already held file
+ */
+t_FileDescriptor *VFS_dup_descriptor(t_FileDescriptor *file);
+
+/**
+ * drops a reference, the file is closed with the last one
+ */
+void VFS_put_descriptor(t_FileDescriptor *file);
+
+/**
+ * every process has its own descriptor table, an fd
+ *  indexes files and used has a bit set for every
+ *  slot that is taken
+ */
+typedef struct {
+    t_FileDescriptor **files;
+    uint32_t *used;
+    /* slots in files, a multiple of 32 */
+    size_t size;
+} t_FDTable;
+
+/**
+ * the table of the running process, the kernel has its
+ *  own for the descriptors opened before the first one
+ */
+t_FDTable *VFS_fd_table();
+
+/**
+ * fills table with another reference to every
+ *  open file of parent, same fds
+ */
+void VFS_fd_table_copy(t_FDTable *table, const t_FDTable *parent);
+
+/**
+ * drops every descriptor of table and frees it
+ */
+void VFS_fd_table_free(t_FDTable *table);
+
 /**
  * modes used for opening files
  */
@@ -216,6 +318,28 @@ typedef enum {
     VFS_SEEK_END = 2,
 } e_VFSSEEKMODES;
 
+/**
+ * walks the components of a path in place,
+ *  name/len point into the path itself so
+ *  names are NOT null terminated
+ */
+typedef struct {
+    const char *pos, *end;
+    const char *name;
+    size_t len;
+} t_PathIter;
+
+/**
+ * starts iterating over the first len bytes of path
+ */
+void VFS_path_iter(t_PathIter *iter, const char *path, size_t len);
+
+/**
+ * moves to the next component, false when there
+ *  are none left, empty components are skipped
+ */
+bool VFS_path_next(t_PathIter *iter);
+
 /**
  * VFS PUBLIC API END
  */
@@ -230,13 +354,32 @@ typedef struct {
     const t_FSContext *ctx;
 } t_MountPoint;
 
+#define VFS_NAME_MAX       64
+#define VFS_DENTRY_BUCKETS 64
+/* cached vnodes (positive and negative) before the lru ones get evicted */
+#define VFS_DENTRY_MAX     256
+
+/**
+ * vnodes double as the dentry cache, they are hashed
+ *  by (parent, name) and kept on an lru list
+ * 
+ * a vnode with a NULL handle is a negative entry,
+ *  caching that name does NOT exist in parent
+ */
 typedef struct t_VFSNode {
     struct t_VFSNode *parent, 
-    /* linked list of children */
-                     *children,
-                     *next;
+                     *hash_next,
+                     *lru_prev,
+                     *lru_next;
+    /* cached children, only leaves can be evicted */
+    uint32_t num_children;
+    /* mount roots are never evicted */
+    bool pinned;
+    /* open files, a referenced vnode is never evicted */
+    uint32_t refs;
     t_FSNode *handle;
     t_VFSOperations *driver; 
+    char name[VFS_NAME_MAX];
 } t_VFSNode;
 
 /**
@@ -250,7 +393,11 @@ typedef struct t_VFSNode {
  */
 typedef struct t_FileDescriptor {
     t_FSFile descriptor;
-    t_VFSOperations *driver
+    t_VFSOperations *driver;
+    t_VFSNode *vnode;
+    uint8_t mode;
+    /* the descriptor table and file mappings */
+    uint32_t refs;
 } t_FileDescriptor;
 
 /**
@@ -273,16 +420,23 @@ t_VFSNode *VFS_lookup(t_VFSNode *parent, const char *name);
 t_VFSNode *VFS_walk_path(const char *_path);
 
 /**
- * makes and allocates a new vnode given the parent vnode
- * 	and the underlying handle
+ * makes and allocates a new vnode given the parent vnode,
+ * 	its name and the underlying handle (NULL for a
+ * 	negative entry)
  */
-t_VFSNode *VFS_make_vnode(t_VFSNode *parent, t_FSNode *handle);
+t_VFSNode *VFS_make_vnode(t_VFSNode *parent, const char *name, t_FSNode *handle);
 
 /**
- * inserts a vnode into a directory vnode
+ * inserts a vnode into the dentry cache under its parent
  */
 void VFS_insert_vnode(t_VFSNode *parent, t_VFSNode *child);
 
+/**
+ * drops the cached (positive or negative) entry
+ * 	for name in parent
+ */
+void VFS_invalidate(t_VFSNode *parent, const char *name);
+
 /**
  * returns the name of the file in *out_fname and the
  * 	vnode for the directory in the actual return
@@ -132,6 +132,20 @@ void switch_pd(pdirectory_t *new_pd);
 void *valloc_page(void *vaddr);
 void vfree_page(void *vaddr);
 
+/**
+ * returns a physical frame that is already zeroed, most
+ *  come from a pool the timer keeps filled with freed
+ *  frames so faults don't have to clear them
+ */
+void *alloc_zeroed_page();
+
+/**
+ * clear/copy a whole mapped page, non-temporal
+ *  stores when the cpu has sse2
+ */
+void page_zero(void *vaddr);
+void page_copy(void *dst, const void *src);
+
 void *vmm_map_big_page(void *paddr, void *vaddr);
 void *valloc_big_page(void *vaddr);
 
@@ -161,6 +175,13 @@ pdirectory_t *new_page_directory();
  */
 void vmm_new_permissions(void *vaddr, bool write, bool ring3);
 
+/**
+ * clears the dirty bit of the PTE relating to vaddr,
+ *  returns whether the page was written since the
+ *  last call
+ */
+bool vmm_clear_dirty(void *vaddr);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,71 @@
+#include <kernel/bench.h>
+
+#ifdef BENCH
+
+#define _STRING_H_INTERNAL
+#include <string.h>
+#include <stdio.h>
+#include <kernel/kmm.h>
+#include <kernel/io.h>
+
+#define BENCH_MAX  0x10000
+#define BENCH_RUNS 64
+
+typedef void (*f_Copy)(void *, const void *, size_t);
+typedef void (*f_Set)(void *, uint8_t, size_t);
+
+static uint32_t BENCH_copy(f_Copy fn, void *dst, const void *src, size_t len){
+    uint64_t start = cpu_tsc();
+
+    for (int i = 0; i < BENCH_RUNS; ++i)
+        fn(dst, src, len);
+
+    return (cpu_tsc() - start) / BENCH_RUNS;
+}
+
+static uint32_t BENCH_set(f_Set fn, void *dst, size_t len){
+    uint64_t start = cpu_tsc();
+
+    for (int i = 0; i < BENCH_RUNS; ++i)
+        fn(dst, 0xAA, len);
+
+    return (cpu_tsc() - start) / BENCH_RUNS;
+}
+
+void BENCH_mem(){
+    if (!mem_has_sse2){
+        printf("BENCH: no sse2, only rep movsd/stosd in use\n");
+        return;
+    }
+
+    /* the source is off by one so the loads are unaligned, as they usually are */
+    uint8_t *src = kmalloc(BENCH_MAX + 1),
+            *dst = kmalloc(BENCH_MAX);
+
+    size_t copy_cross = 0, 
+           set_cross  = 0;
+
+    printf("BENCH: size movsd sse2 stosd sse2 (cycles/call)\n");
+
+    for (size_t len = 16; len <= BENCH_MAX; len *= 2){
+        uint32_t movsd     = BENCH_copy(memcpy_movsd, dst, src + 1, len),
+                 copy_sse2 = BENCH_copy(memcpy_sse2,  dst, src + 1, len),
+                 stosd     = BENCH_set(memset_stosd,  dst, len),
+                 set_sse2  = BENCH_set(memset_sse2,   dst, len);
+
+        printf("BENCH: %d %d %d %d %d\n", len, movsd, copy_sse2, stosd, set_sse2);
+
+        if (!copy_cross && copy_sse2 < movsd) copy_cross = len;
+        if (!set_cross  && set_sse2  < stosd) set_cross  = len;
+    }
+
+    printf(
+        "BENCH: sse2 wins from %d (copy) and %d (set), using %d and %d\n",
+        copy_cross, set_cross, MEM_SSE2_COPY_MIN, MEM_SSE2_SET_MIN
+    );
+
+    kfree(src);
+    kfree(dst);
+}
+
+#endif
@@ -2,6 +2,7 @@
 #include <kernel/tty.h>
 #include <kernel/kmm.h>
 #include <kernel/ps2.h>
+#include <kernel/sys.h>
 
 t_VFSOperations dev_vfs_ops = (t_VFSOperations){
     .f_Mount    = (void*) DEV_init,
@@ -10,8 +11,8 @@ t_VFSOperations dev_vfs_ops = (t_VFSOperations){
     .f_Lookup   = (void*) DEV_lookup,
     .f_Create   = (void*) NULL,
     .f_Remove   = (void*) NULL,
-    .f_Open     = (void*) NULL,
-    .f_Close    = (void*) NULL,
+    .f_Open     = (void*) DEV_open,
+    .f_Close    = (void*) DEV_close,
     .f_Read     = (void*) DEV_read,
     .f_Write    = (void*) DEV_write,
     .f_ReadDir  = (void*) DEV_readdir,
@@ -75,6 +76,14 @@ t_FSContext DEV_init(){
 
     DEV_add_file(&stdin);
 
+    t_DeviceFile syscalls = (t_DeviceFile){
+        .name    = strdup("SYSCALLS"),
+        .f_read_at = SYS_stats_read,
+        .f_write   = SYS_stats_reset
+    };
+
+    DEV_add_file(&syscalls);
+
     return (void*) &dev_vfs_ops;
 }
 
@@ -109,16 +118,41 @@ t_DeviceFile *DEV_lookup(t_FSNode parent, const char *name){
     return NULL;
 }
 
-size_t DEV_read(t_FSNode *file, size_t bytes, void *buff){
-    t_DeviceFile *descriptor = (t_DeviceFile*) file;
+/* an open device, only f_read_at devices use the position */
+typedef struct {
+    t_DeviceFile *node;
+    size_t pos;
+} t_DeviceOpen;
 
-    return descriptor->f_read(buff, bytes);
+t_FSFile DEV_open(t_FSNode *file, uint8_t mode){
+    t_DeviceOpen *open = kmalloc(sizeof *open);
+    if (!open) return NULL;
+
+    *open = (t_DeviceOpen){ .node = (t_DeviceFile*) file, .pos = 0 };
+
+    return open;
 }
 
-size_t DEV_write(t_FSNode *file, size_t bytes, const void *buff){
-    t_DeviceFile *descriptor = (t_DeviceFile*) file;
+void DEV_close(t_FSFile file){
+    kfree(file);
+}
+
+size_t DEV_read(t_FSFile file, size_t bytes, void *buff){
+    t_DeviceOpen *open = file;
+
+    if (!open->node->f_read_at)
+        return open->node->f_read(buff, bytes);
+
+    size_t res = open->node->f_read_at(buff, bytes, open->pos);
+    open->pos += res;
+
+    return res;
+}
+
+size_t DEV_write(t_FSFile file, size_t bytes, const void *buff){
+    t_DeviceOpen *open = file;
 
-    return descriptor->f_write(buff, bytes);
+    return open->node->f_write(buff, bytes);
 }
 
 t_DeviceFile *DEV_readdir(t_FSNode dir, size_t n){
@@ -1,5 +1,15 @@
 #include <kernel/dma.h>
 #include <kernel/io.h>
+#include <kernel/pmm.h>
+#include <kernel/vmm.h>
+
+#define DMA_POOL_PAGES (PMM_DMA_POOL_SIZE / MEMORY_BLOCK_SIZE)
+#define DMA_BANK_PAGES (PMM_DMA_POOL_ALIGN / MEMORY_BLOCK_SIZE)
+
+static uint8_t *pool_vaddr;
+static uint32_t pool_paddr;
+/* one bit per page of the pool */
+static uint32_t pool_used;
 
 void DMA_init(){
     port_write_byte(DMA1_COMMAND_REG, 0x0);
@@ -118,4 +128,80 @@ void DMA_reset(uint8_t dma){
 
 void DMA_unmask_all(){
     port_write_byte(DMA1_UNMASK_ALL_REG, 0xFF);
-}
\ No newline at end of file
+}
+
+/* map the pool reserved by the pmm the first time it is needed */
+static int DMA_pool_init(){
+    pool_paddr = (uint32_t)PMM_dma_pool();
+    if (!pool_paddr) return -1;
+
+    for (size_t i = 0; i < DMA_POOL_PAGES; ++i)
+        vmm_map_page(
+            (void*)(pool_paddr + i * MEMORY_BLOCK_SIZE),
+            (void*)(DMA_POOL_VADDR + i * MEMORY_BLOCK_SIZE),
+            true, false
+        );
+
+    pool_vaddr = (uint8_t*)DMA_POOL_VADDR;
+    return 0;
+}
+
+void *DMA_alloc(size_t len, uint32_t *out_paddr){
+    size_t n = (len + MEMORY_BLOCK_SIZE - 1) / MEMORY_BLOCK_SIZE;
+
+    if (!len || len > DMA_MAX_TRANSFER) return NULL;
+    if (!pool_vaddr && DMA_pool_init()) return NULL;
+
+    for (size_t page = 0; page + n <= DMA_POOL_PAGES; ++page){
+        /* the pool is bank aligned, so a run crossing a bank crosses 64KiB */
+        if (page / DMA_BANK_PAGES != (page + n - 1) / DMA_BANK_PAGES)
+            continue;
+
+        uint32_t mask = (n == 32 ? 0xFFFFFFFF : (1u << n) - 1) << page;
+
+        if (pool_used & mask) continue;
+
+        pool_used |= mask;
+
+        *out_paddr = pool_paddr + page * MEMORY_BLOCK_SIZE;
+        return pool_vaddr + page * MEMORY_BLOCK_SIZE;
+    }
+
+    return NULL;
+}
+
+void DMA_free(void *buff, size_t len){
+    size_t n    = (len + MEMORY_BLOCK_SIZE - 1) / MEMORY_BLOCK_SIZE;
+    size_t page = ((uint8_t*)buff - pool_vaddr) / MEMORY_BLOCK_SIZE;
+
+    if (!buff || !n || page + n > DMA_POOL_PAGES) return;
+
+    pool_used &= ~((n == 32 ? 0xFFFFFFFF : (1u << n) - 1) << page);
+}
+
+int DMA_setup_transfer(uint8_t channel, uint32_t paddr, size_t len, uint8_t mode){
+    /* channels 5-7 are 16 bit, they count words and can cross up to 128KiB */
+    bool    wide  = channel >= 4;
+    uint8_t shift = wide ? 17 : 16;
+
+    if (!len || len > (DMA_MAX_TRANSFER << wide) || paddr + len > PMM_DMA_ZONE_END)
+        return -1;
+    if (paddr >> shift != (paddr + len - 1) >> shift)
+        return -1;
+
+    DMA_set_mask(channel, true);
+
+    DMA_reset_flipflop(wide);
+    DMA_set_full_address(
+        channel, 
+        wide ? (paddr & 0xFF0000) | ((paddr >> 1) & 0xFFFF) : paddr
+    );
+    DMA_reset_flipflop(wide);
+
+    DMA_set_count(channel, (wide ? len / 2 : len) - 1);
+
+    /* unmasks the channel again */
+    DMA_set_mode(channel, mode);
+
+    return 0;
+}
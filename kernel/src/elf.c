@@ -75,8 +75,7 @@ void elf_load_segments(t_Process *process, elf32_header_t *header){
             /* round down to page boundary */
             elf32_addr page_begin = p_header->vaddr - (p_header->vaddr % 0x1000);
 
-            elf32_addr file_end = p_header->vaddr + p_header->file_size,
-                       mem_end  = page_begin + p_header->mem_size,
+            elf32_addr mem_end  = page_begin + p_header->mem_size,
                        /* round up to page boundary */
                        bss_end  = ((mem_end + 0x1000 - 1) / 0x1000) * 0x1000
             ;
@@ -93,8 +92,7 @@ void elf_load_segments(t_Process *process, elf32_header_t *header){
                 (void*) header + p_header->offset, 
                 p_header->file_size
             );
-            /* zero trailing bss */
-            memset((void*) file_end, 0, bss_end - file_end);
+            /* the trailing bss is already zero, umap_pages maps zeroed frames */
         }
     }
 }
@@ -1,5 +1,6 @@
 #include <kernel/exe.h>
 #include <kernel/tss.h>
+#include <kernel/vdso.h>
 
 t_Process *process_stack;
 
@@ -31,7 +32,7 @@ void *new_stack(int argc, const char **argv){
 
     for (int i = 0; i < 64; ++i){
         page -= 0x1000;
-        valloc_page(page);
+        vmm_map_page(alloc_zeroed_page(), page, true, false);
     }
 
     void *stack_base 
@@ -43,8 +44,13 @@ void *new_stack(int argc, const char **argv){
 t_Process *new_process(int argc, char **argv){
     t_Process *new_proc = kmalloc(sizeof(t_Process));
 
+    new_proc->blocks = NULL;
+    new_proc->ring   = NULL;
     new_proc->address_space = new_page_directory();
 
+    /* open files are inherited, the first process gets the kernel's */
+    VFS_fd_table_copy(&new_proc->fds, VFS_fd_table());
+
     if (process_stack)
         new_proc->prev = process_stack;
     else
@@ -57,6 +63,8 @@ t_Process *new_process(int argc, char **argv){
         curr_page_directory, true, false
     );
 
+    VDSO_map();
+
     new_proc->context = (registers_t){0};
 
     new_proc->context = (registers_t){
@@ -74,7 +82,7 @@ t_Process *new_process(int argc, char **argv){
 int execute(const void *file_buff, int argc, char **argv){
     new_process(argc, argv);
 
-    f_entry entry = elf_load(file_buff);
+    f_entry entry = elf_load(process_stack, file_buff);
 
     process_stack->context.eip = (uint32_t) entry;
 
@@ -108,8 +116,13 @@ void exit_process(int code){
         for (;;) ;
     }
 
-    /* technically use-after-free, but nobody else is calling kmalloc() so its fine... */
-    kfree(dying->kernel_stack);
+    VFS_fd_table_free(&dying->fds);
+
+    /* the time page is shared, it can't go with the rest */
+    VDSO_unmap();
+
+    /* the page cache owns the frames behind file mappings */
+    umm_unmap_files(dying);
 
     for (void *p = 0; p < 768 * 1024; ++p){
         void *page = (void*) ((uint32_t) p * 0x1000);
@@ -120,6 +133,12 @@ void exit_process(int code){
     free_page(dying->address_space);
 
     process_stack = revive;
+
+    /**
+     * technically use-after-free, but nothing from here on calls kmalloc()
+     *  so its fine... (closing files can, which is why this goes last)
+     */
+    kfree(dying->kernel_stack);
     kfree(dying);
 
     registers_t *revive_regs = 
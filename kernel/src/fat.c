@@ -36,6 +36,8 @@ void FAT_init_type(t_FATContext *context) {
 
     size_t num_clusters = num_data_sectors / boot_sec->sectors_per_cluster;
 
+    context->num_clusters = num_clusters;
+
     if (num_clusters < 4085)
         context->type = FAT_12; else
     if (num_clusters < 65525)
@@ -62,52 +64,159 @@ size_t FAT_get_offset(t_FATContext *context, uint32_t cluster){
     }
 }
 
+/* marks the FAT sectors covering [offset, offset + len) for writeback */
+static void FAT_mark_dirty(t_FATContext *ctx, size_t offset, size_t len){
+    size_t bps = ctx->boot_sector.bytes_per_sector;
+
+    for (size_t sec = offset / bps; sec <= (offset + len - 1) / bps; ++sec)
+        ctx->fat_dirty[sec / 8] |= 1 << (sec % 8);
+}
+
+/* bytes an entry touches at its offset, FAT12 entries straddle a pair */
+static size_t FAT_entry_width(t_FATContext *context){
+    return context->type == FAT_32 ? 4 : 2;
+}
+
+/**
+ * keeps the free cluster bitmap and count in sync with
+ *  the FAT, a set bit means the cluster is in use
+ */
+static void FAT_free_map_set(t_FATContext *ctx, uint32_t cluster, bool used){
+    if (cluster < 2 || cluster >= ctx->num_clusters + 2) return;
+
+    uint32_t *word = ctx->free_map + cluster / 32,
+              bit  = 1u << (cluster % 32);
+
+    if (used == !!(*word & bit)) return;
+
+    if (used){
+        *word |= bit;
+        --ctx->free_count;
+    }
+    else {
+        *word &= ~bit;
+        ++ctx->free_count;
+    }
+
+    ctx->fsinfo_dirty = true;
+}
+
+/**
+ * builds the free cluster bitmap from the cached FAT,
+ *  clusters past the end of the volume are marked used
+ *  so the allocator never hands them out
+ */
+static int FAT_build_free_map(t_FATContext *ctx){
+    uint32_t end   = ctx->num_clusters + 2,
+             words = (end + 31) / 32;
+
+    ctx->free_map = kmalloc(words * sizeof(uint32_t));
+    if (!ctx->free_map) return -1;
+
+    memset(ctx->free_map, 0xFF, words * sizeof(uint32_t));
+    ctx->free_count = 0;
+
+    for (uint32_t cluster = 2; cluster < end; ++cluster)
+        if (!FAT_get_entry(ctx, 0, cluster)){
+            ctx->free_map[cluster / 32] &= ~(1u << (cluster % 32));
+            ++ctx->free_count;
+        }
+
+    return 0;
+}
+
+/**
+ * reads the allocation hint from the FAT32 FSInfo sector,
+ *  the free count is recomputed from the bitmap regardless
+ */
+static void FAT_read_fsinfo(t_FATContext *ctx){
+    t_FAT32_FSInfo fsinfo;
+
+    ctx->fsinfo_valid = false;
+    ctx->next_free    = 2;
+
+    if (ctx->type != FAT_32 || !ctx->fat32_ext.fsinfo_sector_num)
+        return;
+
+    SAL_read(
+        ctx->device, sizeof fsinfo, 
+        ctx->fat32_ext.fsinfo_sector_num * ctx->boot_sector.bytes_per_sector, &fsinfo
+    );
+
+    if (fsinfo.lead_signature   != FAT_FSINFO_LEAD_SIG  ||
+        fsinfo.middle_signature != FAT_FSINFO_STRUC_SIG ||
+        fsinfo.trail_signature  != FAT_FSINFO_TRAIL_SIG)
+        return;
+
+    ctx->fsinfo_valid = true;
+
+    if (fsinfo.last_free_cluster >= 2 && fsinfo.last_free_cluster < ctx->num_clusters + 2)
+        ctx->next_free = fsinfo.last_free_cluster;
+
+    /* the stored count may be stale, write ours back on the next flush */
+    ctx->fsinfo_dirty = fsinfo.num_free_clusters != ctx->free_count;
+}
+
+static void FAT_write_fsinfo(t_FATContext *ctx){
+    if (!ctx->fsinfo_valid || !ctx->fsinfo_dirty) return;
+
+    uint32_t hint[2] = { ctx->free_count, ctx->next_free };
+
+    SAL_write(
+        ctx->device, sizeof hint,
+        ctx->fat32_ext.fsinfo_sector_num * ctx->boot_sector.bytes_per_sector +
+            __builtin_offsetof(t_FAT32_FSInfo, num_free_clusters),
+        hint
+    );
+
+    ctx->fsinfo_dirty = false;
+}
+
 /**
- * sets the FAT entry for a said cluster and said FAT;
+ * sets the FAT entry for a said cluster in the cached FAT;
+ * the cache stands for every FAT copy, so fat_num is ignored
+ *  and all copies get the change on FAT_flush;
  * returns ~data on failure, data on success;
  */
 uint32_t FAT_set_entry(t_FATContext *context, uint8_t fat_num, uint32_t cluster, uint32_t data){
-    size_t offset = context->boot_sector.reserved_sectors * context->boot_sector.bytes_per_sector;
-    offset += fat_num * SECTORS_PER_FAT(context) * context->boot_sector.bytes_per_sector;
-    offset += FAT_get_offset(context, cluster);
+    size_t offset = FAT_get_offset(context, cluster);
+
+    if (offset + FAT_entry_width(context) > context->fat_size) return ~data;
 
-    uint32_t entry = 0;
+    uint8_t *entry = context->fat + offset;
+
+    FAT_free_map_set(context, cluster, !!(data & 0x0FFFFFFF));
 
     switch(context->type){
         case FAT_12: {
-            SAL_read(context->device, 2, offset, &entry);
-
             /* preserve either top or bottom nibble since entries are 12 bits */
 
             if (cluster % 2){
-                data <<= 4;
-                entry &= 0x000F;
+                entry[0] = (entry[0] & 0x0F) | (data << 4);
+                entry[1] = data >> 4;
             }
             else {
-                data  &= 0x0FFF;
-                entry &= 0xF000;
+                entry[0] = data;
+                entry[1] = (entry[1] & 0xF0) | ((data >> 8) & 0x0F);
             }
 
-            data |= entry;
-
-            /* fall through to FAT16 case */
+            FAT_mark_dirty(context, offset, 2);
+            break;
         }
 
         case FAT_16: {
-            SAL_write(context->device, 2, offset, &data);
+            *(uint16_t*)entry = data;
+
+            FAT_mark_dirty(context, offset, 2);
             break;
         }
 
         case FAT_32: {
-            SAL_read(context->device, 4, offset, &entry);
-
             /* top nibble must be preserved */
 
-            data &= 0x0FFFFFFF;
-            data |= entry & 0xF0000000;
-
-            SAL_write(context->device, 4, offset, &data);
+            *(uint32_t*)entry = (data & 0x0FFFFFFF) | (*(uint32_t*)entry & 0xF0000000);
 
+            FAT_mark_dirty(context, offset, 4);
             break;
         }
 
@@ -118,51 +227,76 @@ uint32_t FAT_set_entry(t_FATContext *context, uint8_t fat_num, uint32_t cluster,
 }
 
 static void FAT_set_entries(t_FATContext *ctx, uint32_t num, uint32_t data){
-    for (uint8_t i = 0; i < ctx->boot_sector.num_fat; ++i)
-        FAT_set_entry(ctx, i, num, data);
+    FAT_set_entry(ctx, 0, num, data);
 }
 
 /**
- * gets the FAT entry for said FAT and said cluster;
+ * gets the FAT entry for said cluster from the cached FAT;
  * returns 0 on failure;
  */
 uint32_t FAT_get_entry(t_FATContext *context, uint8_t fat_num, uint32_t cluster){
-    size_t offset = context->boot_sector.reserved_sectors * context->boot_sector.bytes_per_sector;
-    offset += fat_num * SECTORS_PER_FAT(context) * context->boot_sector.bytes_per_sector;
-    offset += FAT_get_offset(context, cluster);
+    size_t offset = FAT_get_offset(context, cluster);
+
+    if (offset + FAT_entry_width(context) > context->fat_size) return 0;
 
-    uint32_t entry = 0;
+    uint8_t *entry = context->fat + offset;
 
     switch(context->type){
         case FAT_12: {
-            SAL_read(context->device, 2, offset, &entry);
-            
+            uint16_t val = entry[0] | entry[1] << 8;
+
             /* discard either top or bottom nibble since entries are 12 bits */
 
             if (cluster % 2)
-                return entry >> 4;
+                return val >> 4;
             else
-                return entry & 0x0FFF;
+                return val & 0x0FFF;
         }
         
-        case FAT_16: {
-            SAL_read(context->device, 2, offset, &entry);
-            return entry;
-        }
+        case FAT_16:
+            return *(uint16_t*)entry;
         
-        case FAT_32: {
-            SAL_read(context->device, 4, offset, &entry);
-
+        case FAT_32:
             /* discard top nibble since entries are 28 bits */
-
-            return entry & ~0xF;
-        }
+            return *(uint32_t*)entry & 0x0FFFFFFF;
 
         case FAT_NULL:
             return 0;
     }
 }
 
+/**
+ * writes the dirty sectors of the cached FAT
+ *  back to every FAT copy on disk
+ */
+void FAT_flush(t_FATContext *ctx){
+    size_t bps       = ctx->boot_sector.bytes_per_sector,
+           fat_start = ctx->boot_sector.reserved_sectors * bps,
+           fat_bytes = SECTORS_PER_FAT(ctx) * bps;
+
+    for (size_t sec = 0; sec < ctx->fat_sectors;){
+        if (!(ctx->fat_dirty[sec / 8] & (1 << (sec % 8)))){
+            ++sec;
+            continue;
+        }
+
+        /* write runs of dirty sectors in one go */
+        size_t run = sec;
+        for (; run < ctx->fat_sectors && ctx->fat_dirty[run / 8] & (1 << (run % 8)); ++run)
+            ctx->fat_dirty[run / 8] &= ~(1 << (run % 8));
+
+        for (uint8_t i = 0; i < ctx->boot_sector.num_fat; ++i)
+            SAL_write(
+                ctx->device, (run - sec) * bps, 
+                fat_start + i * fat_bytes + sec * bps, ctx->fat + sec * bps
+            );
+
+        sec = run;
+    }
+
+    FAT_write_fsinfo(ctx);
+}
+
 /**
  * returns non-zero if the entry marks the end of a cluster
  * chain; 
@@ -178,7 +312,7 @@ bool FAT_is_eoc(t_FATContext *context, uint32_t fat_entry){
             return fat_entry >= 0xFFF8;
 
         case FAT_32:
-            return fat_entry >= 0xFFFFFFF8;
+            return (fat_entry & 0x0FFFFFFF) >= 0x0FFFFFF8;
         
         case FAT_NULL:
             return false;
@@ -317,7 +451,7 @@ e_LongDirEntryType DirEntryType(const t_LongDirEntry *entry){
 size_t RootDirSector(t_FATContext *context){
     t_BootSectorCommon *boot_sector = &context->boot_sector;
 
-    size_t data_region_start = boot_sector->reserved_sectors + (boot_sector->num_fat * boot_sector->sectors_per_fat);
+    size_t data_region_start = boot_sector->reserved_sectors + (boot_sector->num_fat * SECTORS_PER_FAT(context));
     
     if (context->type == FAT_12 || context->type == FAT_16)
         return data_region_start;
@@ -326,16 +460,36 @@ size_t RootDirSector(t_FATContext *context){
 }
 
 /**
- * searches the FAT for a free cluster and returns the
- *  cluster number
+ * finds a free cluster in the free cluster bitmap and 
+ *  returns the cluster number, the search continues
+ *  where the last one left off (next-fit)
  * 
  * returns 0 on failure
  */
 uint32_t FindFreeCluster(t_FATContext *context){
-    size_t num_clusters = context->boot_sector.num_sectors * context->boot_sector.sectors_per_cluster;
-    for (size_t i = 2; i < num_clusters; ++i){
-        uint32_t entry = FAT_get_entry(context, 0, i);
-        if (!entry) return i;
+    uint32_t end   = context->num_clusters + 2,
+             words = (end + 31) / 32,
+             start = context->next_free;
+
+    if (!context->free_count) return 0;
+
+    if (start < 2 || start >= end) start = 2;
+
+    /* the last round wraps back to the bits before start */
+    for (uint32_t i = 0; i <= words; ++i){
+        uint32_t word = (start / 32 + i) % words,
+                 bits = ~context->free_map[word];
+
+        if (!i) bits &= ~0u << (start % 32);
+
+        if (!bits) continue;
+
+        uint32_t cluster = word * 32 + __builtin_ctz(bits);
+
+        context->next_free    = cluster + 1;
+        context->fsinfo_dirty = true;
+
+        return cluster;
     }
 
     return 0;
@@ -353,6 +507,7 @@ t_FATContext *FAT_mount(storage_device_t *dev){
     t_FATContext *context = kmalloc(sizeof(t_FATContext));
     context->device = dev;
     context->partition_start = 0;
+    context->dir_indexes = NULL;
 
     SAL_read(
         context->device, sizeof(t_BootSectorCommon), 
@@ -370,6 +525,10 @@ t_FATContext *FAT_mount(storage_device_t *dev){
         return NULL;
     }
 
+    /* FAT32 keeps the FAT size in the extended boot sector */
+    if (!context->boot_sector.sectors_per_fat)
+        SAL_read(context->device, sizeof(t_BootSector32Ext), sizeof(t_BootSectorCommon), &context->fat32_ext);
+
     FAT_init_type(context);
 
     /* round up */
@@ -378,7 +537,7 @@ t_FATContext *FAT_mount(storage_device_t *dev){
         / context->boot_sector.bytes_per_sector;
 
     context->data_region_start  = context->boot_sector.reserved_sectors;
-    context->data_region_start += context->boot_sector.num_fat * context->boot_sector.sectors_per_fat;
+    context->data_region_start += context->boot_sector.num_fat * SECTORS_PER_FAT(context);
     context->data_region_start += root_sectors;
     context->data_region_start *= context->boot_sector.bytes_per_sector;
 
@@ -400,6 +559,35 @@ t_FATContext *FAT_mount(storage_device_t *dev){
     context->bytes_p_clus = 
         context->boot_sector.sectors_per_cluster * context->boot_sector.bytes_per_sector;
 
+    /* keep the first FAT in memory, chain walks become array lookups */
+    context->fat_sectors = SECTORS_PER_FAT(context);
+    context->fat_size    = context->fat_sectors * context->boot_sector.bytes_per_sector;
+    context->fat         = kmalloc(context->fat_size);
+    context->fat_dirty   = kmalloc((context->fat_sectors + 7) / 8);
+
+    if (!context->fat || !context->fat_dirty){
+        if (context->fat)       kfree(context->fat);
+        if (context->fat_dirty) kfree(context->fat_dirty);
+        kfree(context);
+        return NULL;
+    }
+
+    memset(context->fat_dirty, 0, (context->fat_sectors + 7) / 8);
+    SAL_read(
+        context->device, context->fat_size, 
+        context->boot_sector.reserved_sectors * context->boot_sector.bytes_per_sector, 
+        context->fat
+    );
+
+    if (FAT_build_free_map(context)){
+        kfree(context->fat);
+        kfree(context->fat_dirty);
+        kfree(context);
+        return NULL;
+    }
+
+    FAT_read_fsinfo(context);
+
     context->root = (t_FATHandle){
         .start_cluster = context->type == FAT_32
             ? context->fat32_ext.root_cluster_num : 0,
@@ -492,35 +680,238 @@ bool FAT_is_root(t_FATContext *ctx, uint32_t cluster){
     return  !!FAT_absolute_offset(ctx, 0, clus_off - root_off, NULL);
 }
 
+/**
+ * DIRECTORY INDEX
+ * 
+ * the short entries of a directory are read once, in whole
+ *  clusters, into a hash table of 8.3 name -> entry number
+ *  and first cluster. the index of a directory is kept per
+ *  context and updated by every function that adds or removes
+ *  entries, so lookups dont have to scan the directory
+ */
+
+static uint32_t FAT_name_hash(const uint8_t *name){
+    uint32_t hash = 0;
+
+    for (int i = 0; i < 11; ++i)
+        hash = hash * 31 + name[i];
+
+    return hash % FAT_DIR_BUCKETS;
+}
+
+static t_FATDirSlot *FAT_dir_index_find(t_FATDirIndex *index, const uint8_t *name){
+    t_FATDirSlot *slot = index->buckets[FAT_name_hash(name)];
+
+    while (slot && memcmp(slot->name, name, 11))
+        slot = slot->next;
+
+    return slot;
+}
+
+static void FAT_dir_index_add(t_FATDirIndex *index, const uint8_t *name, uint32_t entry_num, uint32_t cluster){
+    t_FATDirSlot *slot = kmalloc(sizeof *slot);
+    if (!slot) return;
+
+    uint32_t bucket = FAT_name_hash(name);
+
+    memcpy(slot->name, name, 11);
+    slot->entry_num = entry_num;
+    slot->cluster   = cluster;
+    slot->next      = index->buckets[bucket];
+
+    index->buckets[bucket] = slot;
+}
+
+/* remembers a deleted entry so it can be reused */
+static void FAT_dir_index_free_slot(t_FATDirIndex *index, uint32_t entry_num){
+    if (index->num_free == index->cap_free){
+        uint32_t cap = index->cap_free ? index->cap_free * 2 : 8;
+        uint32_t *free_slots = krealloc(index->free_slots, cap * sizeof(uint32_t));
+
+        if (!free_slots) return;
+
+        index->free_slots = free_slots;
+        index->cap_free   = cap;
+    }
+
+    index->free_slots[index->num_free++] = entry_num;
+}
+
+static void FAT_dir_index_remove(t_FATDirIndex *index, const uint8_t *name){
+    t_FATDirSlot **link = &index->buckets[FAT_name_hash(name)];
+
+    while (*link && memcmp((*link)->name, name, 11))
+        link = &(*link)->next;
+
+    if (!*link) return;
+
+    t_FATDirSlot *slot = *link;
+    *link = slot->next;
+
+    FAT_dir_index_free_slot(index, slot->entry_num);
+    kfree(slot);
+}
+
+static void FAT_dir_index_destroy(t_FATDirIndex *index){
+    for (int i = 0; i < FAT_DIR_BUCKETS; ++i)
+        for (t_FATDirSlot *slot = index->buckets[i], *next; slot; slot = next){
+            next = slot->next;
+            kfree(slot);
+        }
+
+    if (index->free_slots)
+        kfree(index->free_slots);
+
+    kfree(index);
+}
+
+/**
+ * adds the entries in entries[0, count) which start at 
+ *  entry number base to the index, returns true once
+ *  the end of directory marker has been seen
+ */
+static bool FAT_dir_index_parse(t_FATDirIndex *index, t_ShortDirEntry *entries, uint32_t count, uint32_t base){
+    for (uint32_t i = 0; i < count; ++i){
+        t_ShortDirEntry *entry = entries + i;
+
+        if (entry->name[0] == 0x00){
+            index->num_entries = base + i;
+            return true;
+        }
+
+        if (entry->name[0] == 0xE5)
+            FAT_dir_index_free_slot(index, base + i);
+        else if (!(entry->attributes & ENTRY_ATTR_VOLUME_ID))
+            FAT_dir_index_add(index, entry->name, base + i, entry->first_cluster_low);
+    }
+
+    index->num_entries = base + count;
+    return false;
+}
+
+static t_FATDirIndex *FAT_dir_index_build(t_FATContext *ctx, uint32_t dir_cluster){
+    t_FATDirIndex *index = kmalloc(sizeof *index);
+    uint8_t *buff = kmalloc(ctx->bytes_p_clus);
+    uint32_t per_clus = ctx->bytes_p_clus / sizeof(t_ShortDirEntry);
+
+    if (!index || !buff){
+        if (index) kfree(index);
+        if (buff)  kfree(buff);
+        return NULL;
+    }
+
+    memset(index, 0, sizeof *index);
+    index->dir_cluster = dir_cluster;
+
+    if (dir_cluster < 2){
+        /* the FAT12/16 root directory is a fixed region before the data */
+        uint32_t total  = ctx->boot_sector.num_root_entries;
+        size_t   offset = RootDirSector(ctx) * ctx->boot_sector.bytes_per_sector;
+
+        index->capacity = total;
+
+        for (uint32_t base = 0; base < total; base += per_clus){
+            uint32_t count = total - base < per_clus ? total - base : per_clus;
+
+            SAL_read(ctx->device, count * sizeof(t_ShortDirEntry), offset + base * sizeof(t_ShortDirEntry), buff);
+            if (FAT_dir_index_parse(index, (t_ShortDirEntry*)buff, count, base))
+                break;
+        }
+    }
+    else {
+        uint32_t cluster = dir_cluster;
+
+        /* grows with the cluster chain */
+        index->capacity = -1;
+
+        for (uint32_t base = 0, i = 0; i < ctx->num_clusters; base += per_clus, ++i){
+            SAL_read(ctx->device, ctx->bytes_p_clus, FAT_clus_to_off(ctx, cluster), buff);
+            if (FAT_dir_index_parse(index, (t_ShortDirEntry*)buff, per_clus, base))
+                break;
+
+            cluster = FAT_get_entry(ctx, 0, cluster);
+            if (FAT_is_eoc(ctx, cluster) || cluster < 2)
+                break;
+        }
+    }
+
+    kfree(buff);
+    return index;
+}
+
+/**
+ * returns the index of the directory starting at dir_cluster,
+ *  building it on first use, recently used indexes are kept
+ *  at the front and the least recently used one is dropped
+ *  once there are too many
+ */
+t_FATDirIndex *FAT_dir_index(t_FATContext *ctx, uint32_t dir_cluster){
+    t_FATDirIndex **link = &ctx->dir_indexes;
+    uint32_t n = 0;
+
+    if (dir_cluster < 2 && ctx->type == FAT_32)
+        dir_cluster = ctx->fat32_ext.root_cluster_num;
+
+    for (; *link; link = &(*link)->next, ++n)
+        if ((*link)->dir_cluster == dir_cluster){
+            t_FATDirIndex *index = *link;
+
+            *link = index->next;
+            index->next = ctx->dir_indexes;
+            ctx->dir_indexes = index;
+
+            return index;
+        }
+
+    t_FATDirIndex *index = FAT_dir_index_build(ctx, dir_cluster);
+    if (!index) return NULL;
+
+    if (n >= FAT_MAX_DIR_INDEXES){
+        link = &ctx->dir_indexes;
+        while ((*link)->next) link = &(*link)->next;
+
+        FAT_dir_index_destroy(*link);
+        *link = NULL;
+    }
+
+    index->next = ctx->dir_indexes;
+    ctx->dir_indexes = index;
+
+    return index;
+}
+
+/* forgets the index of a directory whose clusters are being freed */
+static void FAT_dir_index_drop(t_FATContext *ctx, uint32_t dir_cluster){
+    for (t_FATDirIndex **link = &ctx->dir_indexes; *link; link = &(*link)->next)
+        if ((*link)->dir_cluster == dir_cluster){
+            t_FATDirIndex *index = *link;
+
+            *link = index->next;
+            FAT_dir_index_destroy(index);
+            return;
+        }
+}
+
 /**
  * finds a file in the directory
  *  starting at cluster and returns
  *  the cluster number of the file,
  *  -1 on file-not-found
  */
-uint32_t FAT_find_file(t_FATContext *ctx, uint32_t cluster, const char *_name){
-    int eoc = 0, 
-    entry_num = 0; 
-    
-    t_ShortDirEntry entry;
+uint32_t FAT_find_file(t_FATContext *ctx, uint32_t cluster, const char *name){
+    return FAT_find_file_n(ctx, cluster, name, strlen(name));
+}
 
-    eoc = FAT_dir_entry(ctx, cluster, entry_num, &entry);
-   
+uint32_t FAT_find_file_n(t_FATContext *ctx, uint32_t cluster, const char *_name, size_t len){
     char name[11];
-    FAT_conv_fname(_name, name);
-
-    while (
-        !eoc && memcmp(entry.name, name, 11) && 
-        (entry.attributes & ENTRY_ATTR_VOLUME_ID)
-    ){
-        ++entry_num;
-        eoc = FAT_dir_entry(ctx, cluster, entry_num, &entry);	
-    }
-    
-    if (eoc)
-        return -1;
-    else
-        return entry.first_cluster_low;
+    FAT_conv_fname_n(_name, len, name);
+
+    t_FATDirIndex *index = FAT_dir_index(ctx, cluster);
+    if (!index) return -1;
+
+    t_FATDirSlot *slot = FAT_dir_index_find(index, (uint8_t*)name);
+
+    return slot ? slot->cluster : -1;
 }
 
 /**
@@ -531,51 +922,58 @@ uint32_t FAT_find_file(t_FATContext *ctx, uint32_t cluster, const char *_name){
  * in the root directory special case on FAT12/16,
  *  this function returns 0 as the cluster number
  */
-uint32_t FAT_file_cluster(t_FATContext *ctx, const char *_path){
-     
-    static char path[0xFFF];
-    memset(path, 0, 0xFFF);
-    memcpy(path, _path, strlen(_path));
-
+uint32_t FAT_file_cluster(t_FATContext *ctx, const char *path){
     uint32_t clus =  ctx->type == FAT_32
          ? ctx->fat32_ext.root_cluster_num
          : 0;
 
-    char *name = strtok(path, "/");
+    t_PathIter iter;
+    VFS_path_iter(&iter, path, strlen(path));
 
-    while (name){
-        clus = FAT_find_file(ctx, clus, name);
+    while (VFS_path_next(&iter)){
+        clus = FAT_find_file_n(ctx, clus, iter.name, iter.len);
 
         if (clus == 0xFFFFFFFF)
             return -1;
-
-        name = strtok(NULL, "/");
     }
 
     return clus;
 }
 
 void FAT_write_entry(t_FATContext *ctx, uint32_t cluster, void *entry){
-    int entry_num = 0;
-    t_ShortDirEntry read_entry;
-    int eoc = FAT_dir_entry(ctx, cluster, entry_num, &read_entry);   
+    t_FATDirIndex *index = FAT_dir_index(ctx, cluster);
+    if (!index) return;
 
-    for (; !eoc; ++entry_num){
-        retry_search:
+    /* reuse a deleted entry before growing the directory */
+    uint32_t entry_num = index->num_free
+        ? index->free_slots[--index->num_free]
+        : index->num_entries;
 
-        eoc = FAT_dir_entry(ctx, cluster, entry_num, &read_entry);
-        if (read_entry.name[0] == 0x00 || read_entry.name[0] == 0xE5){
-            size_t offset = FAT_clus_to_off(ctx, cluster) + entry_num * sizeof(t_ShortDirEntry); 
-            SAL_write(ctx->device, sizeof(t_ShortDirEntry), offset, entry);
-            return;
+    if (entry_num >= index->capacity) return;
+
+    size_t offset = FAT_absolute_offset(ctx, cluster, entry_num * sizeof(t_ShortDirEntry), NULL);
+
+    if (!offset){
+        uint32_t new_clus = FAT_allocate_cluster(ctx, cluster);
+        if (!new_clus) return;
+
+        uint8_t *zero = kmalloc(ctx->bytes_p_clus);
+        if (zero){
+            memset(zero, 0, ctx->bytes_p_clus);
+            SAL_write(ctx->device, ctx->bytes_p_clus, FAT_clus_to_off(ctx, new_clus), zero);
+            kfree(zero);
         }
+
+        offset = FAT_absolute_offset(ctx, cluster, entry_num * sizeof(t_ShortDirEntry), NULL);
     }
 
-    FAT_allocate_cluster(ctx, cluster);
+    SAL_write(ctx->device, sizeof(t_ShortDirEntry), offset, entry);
 
-    eoc = 0;
+    if (entry_num == index->num_entries)
+        ++index->num_entries;
 
-    goto retry_search;
+    t_ShortDirEntry *short_entry = entry;
+    FAT_dir_index_add(index, short_entry->name, entry_num, short_entry->first_cluster_low);
 }
 
 /**
@@ -584,11 +982,14 @@ void FAT_write_entry(t_FATContext *ctx, uint32_t cluster, void *entry){
  * 11 characters
  */
 void FAT_conv_fname(const char *name, char *out){
-    int i = 0;
-    int l = strlen(name);
+    FAT_conv_fname_n(name, strlen(name), out);
+}
+
+void FAT_conv_fname_n(const char *name, size_t l, char *out){
+    size_t i = 0;
    
     /* handle '.' and '..' special case */
-    if (name[0] == '.' && l < 3){
+    if (l && name[0] == '.' && l < 3){
         memcpy(out, name, l);
         memset(out + l, ' ', 11 - l);
         return;
@@ -597,13 +998,17 @@ void FAT_conv_fname(const char *name, char *out){
     for (; i < l && i < 8 && name[i] != '.'; ++i)
         out[i] = name[i];
     
-    int j = i;
+    size_t j = i;
     for (; j < 8; ++j)
         out[j] = ' ';
 
+    /* the extension starts after the dot, wherever the base got cut */
+    while (i < l && name[i] != '.')
+        ++i;
+
     ++i;
 
-    for (; i < l && i < 11; ++i, ++j)
+    for (; i < l && j < 11; ++i, ++j)
         out[j] = name[i];
 
     for (; j < 11; ++j)
@@ -686,42 +1091,50 @@ uint32_t FAT_split_path(char *path){
  * as free
  */
 void FAT_free_cluster_chain(t_FATContext *ctx, uint32_t cluster){
-    while (!FAT_is_eoc(ctx, cluster)){
+    /* it might have been a directory */
+    FAT_dir_index_drop(ctx, cluster);
+
+    for (uint32_t i = 0; i < ctx->num_clusters; ++i){
+        if (cluster < 2 || cluster >= ctx->num_clusters + 2)
+            break;
+
         uint32_t next = FAT_get_entry(ctx, 0, cluster);
 
         FAT_set_entries(ctx, cluster, 0x0);
 
+        if (FAT_is_eoc(ctx, next))
+            break;
+
         cluster = next; 
     }
-    
-    /* set last cluster to free */
-    FAT_set_entries(ctx, cluster, 0x0);
 }
 
-void FAT_file_entry(t_FATHandle *file, t_ShortDirEntry *out_entry){
+/**
+ * reads the directory entry of file into out_entry,
+ *  returns its entry number in the parent directory
+ *  or -1 (and a zeroed entry) if it doesnt exist
+ */
+uint32_t FAT_file_entry(t_FATHandle *file, t_ShortDirEntry *out_entry){
     char conv_fname[11];
     FAT_conv_fname(file->name, conv_fname);
 
-    bool eoc = FAT_dir_entry(file->ctx, file->dir_cluster, 0, out_entry);
-
-    for (uint32_t i = 0; !eoc; ++i){
-        if (
-            !memcmp(out_entry, conv_fname, 11) &&
-            !(out_entry->attributes & ENTRY_ATTR_VOLUME_ID)
-        ) 
-            return;
+    t_FATDirIndex *index = FAT_dir_index(file->ctx, file->dir_cluster);
+    t_FATDirSlot  *slot  = index ? FAT_dir_index_find(index, (uint8_t*)conv_fname) : NULL;
 
-        eoc = FAT_dir_entry(file->ctx, file->dir_cluster, i + 1, out_entry);
-    }
+    if (slot && !FAT_dir_entry(file->ctx, file->dir_cluster, slot->entry_num, out_entry))
+        return slot->entry_num;
 
     memset(out_entry, 0, sizeof *out_entry);
+    return -1;
 }
 
 /**
  * allocates a new cluster for the
- *  cluster chain starting at cluster
+ *  cluster chain starting at cluster,
+ *  returns the new cluster or 0 if
+ *  the volume is full
  */
-void FAT_allocate_cluster(t_FATContext *ctx, uint32_t _cluster){
+uint32_t FAT_allocate_cluster(t_FATContext *ctx, uint32_t _cluster){
     uint32_t cluster = _cluster;
     uint32_t next = FAT_get_entry(ctx, 0, cluster);
     while (!FAT_is_eoc(ctx, next)){
@@ -730,9 +1143,224 @@ void FAT_allocate_cluster(t_FATContext *ctx, uint32_t _cluster){
     }
 
     uint32_t free_clus = FindFreeCluster(ctx);
+    if (!free_clus) return 0;
+
     FAT_set_entries(ctx, cluster, free_clus);
     FAT_set_entries(ctx, free_clus, 0xFFFFFFFF);
 
+    return free_clus;
+}
+
+/**
+ * EXTENT MAP
+ * 
+ * an open file keeps its cluster chain as a sorted list of runs
+ *  of contiguous clusters, built the first time an offset has
+ *  to be translated and extended as clusters are appended
+ */
+
+/* appends a run of len clusters starting at cluster to the map */
+static int FAT_extent_append(t_FATFile *file, uint32_t cluster, uint32_t len){
+    t_FATExtent *last = file->num_extents 
+        ? file->extents + file->num_extents - 1 
+        : NULL;
+
+    if (last && last->disk_clus + last->len == cluster){
+        last->len += len;
+        goto appended;
+    }
+
+    if (file->num_extents == file->cap_extents){
+        uint32_t cap = file->cap_extents ? file->cap_extents * 2 : 4;
+        t_FATExtent *extents = krealloc(file->extents, cap * sizeof(t_FATExtent));
+
+        if (!extents) return -1;
+
+        file->extents     = extents;
+        file->cap_extents = cap;
+    }
+
+    file->extents[file->num_extents++] = (t_FATExtent){
+        .file_clus = file->num_clus,
+        .disk_clus = cluster,
+        .len       = len
+    };
+
+appended:
+    file->num_clus  += len;
+    file->tail_clus  = cluster + len - 1;
+    return 0;
+}
+
+static void FAT_build_extents(t_FATFile *file){
+    t_FATContext *ctx = file->ctx;
+    uint32_t cluster = file->starting_clus;
+
+    file->extents_built = true;
+
+    /* bounded by the cluster count in case the chain loops */
+    for (uint32_t i = 0; i < ctx->num_clusters; ++i){
+        if (cluster < 2 || cluster >= ctx->num_clusters + 2)
+            break;
+
+        if (FAT_extent_append(file, cluster, 1))
+            break;
+
+        uint32_t next = FAT_get_entry(ctx, 0, cluster);
+        if (FAT_is_eoc(ctx, next) || !next)
+            break;
+
+        cluster = next;
+    }
+}
+
+/**
+ * translates an offset within the file to
+ *  an offset on disk with a binary search
+ *  over the extent map, returns 0 if the
+ *  offset lies past the end of the chain
+ * 
+ * if out_contig is set it receives the number
+ *  of bytes from there on that are contiguous
+ *  on disk
+ */
+size_t FAT_file_offset(t_FATFile *file, size_t position, size_t *out_contig){
+    t_FATContext *ctx = file->ctx;
+    uint32_t index = position / ctx->bytes_p_clus,
+             lo    = 0,
+             hi;
+
+    if (!file->extents_built)
+        FAT_build_extents(file);
+
+    hi = file->num_extents;
+
+    while (lo < hi){
+        uint32_t mid = lo + (hi - lo) / 2;
+        t_FATExtent *extent = file->extents + mid;
+
+        if (index < extent->file_clus)
+            hi = mid;
+        else if (index >= extent->file_clus + extent->len)
+            lo = mid + 1;
+        else {
+            if (out_contig)
+                *out_contig = (extent->file_clus + extent->len) * ctx->bytes_p_clus - position;
+
+            return FAT_clus_to_off(ctx, extent->disk_clus + index - extent->file_clus) 
+                + position % ctx->bytes_p_clus;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * finds a run of up to want free clusters, next-fit from the
+ *  allocation cursor. returns the start of the first run of
+ *  the full length, or the longest run found otherwise
+ * 
+ * returns 0 if the volume is full
+ */
+static uint32_t FAT_find_free_run(t_FATContext *ctx, uint32_t want, uint32_t *out_len){
+    uint32_t end     = ctx->num_clusters + 2,
+             cluster = ctx->next_free,
+             best    = 0,
+             best_len = 0;
+
+    if (!ctx->free_count) return 0;
+
+    if (cluster < 2 || cluster >= end) cluster = 2;
+
+    for (uint32_t scanned = 0; scanned < ctx->num_clusters;){
+        /* runs dont wrap around the end of the volume */
+        if (cluster >= end) cluster = 2;
+
+        /* skip fully used words */
+        if (!(cluster % 32) && ctx->free_map[cluster / 32] == 0xFFFFFFFF){
+            cluster += 32;
+            scanned += 32;
+            continue;
+        }
+
+        if (FAT_CLUSTER_USED(ctx, cluster)){
+            ++cluster;
+            ++scanned;
+            continue;
+        }
+
+        uint32_t len = 0;
+        while (cluster + len < end && len < want && !FAT_CLUSTER_USED(ctx, cluster + len))
+            ++len;
+
+        if (len > best_len){
+            best     = cluster;
+            best_len = len;
+        }
+
+        if (len == want) break;
+
+        cluster += len;
+        scanned += len;
+    }
+
+    if (best){
+        ctx->next_free    = best + best_len;
+        ctx->fsinfo_dirty = true;
+    }
+
+    *out_len = best_len;
+    return best;
+}
+
+/**
+ * makes sure the cluster chain of the file covers [0, end),
+ *  new clusters are taken in contiguous runs, each run is
+ *  linked into the FAT and appended to the extent map at once
+ * 
+ * returns 0 on success, -1 if the volume ran out of space
+ */
+static int FAT_file_reserve(t_FATFile *file, size_t end){
+    t_FATContext *ctx = file->ctx;
+    uint32_t need = (end + ctx->bytes_p_clus - 1) / ctx->bytes_p_clus;
+
+    if (!file->extents_built)
+        FAT_build_extents(file);
+    /**
+     * every open has its own map, if another one grew the chain
+     *  since, the cached tail isn't the end anymore and linking
+     *  from it would cut off the other one's clusters
+     */
+    else if (file->num_clus && !FAT_is_eoc(ctx, FAT_get_entry(ctx, 0, file->tail_clus))){
+        file->num_extents = file->num_clus = 0;
+        FAT_build_extents(file);
+    }
+
+    if (!file->num_clus) return -1;
+
+    while (file->num_clus < need){
+        uint32_t len, first = FAT_find_free_run(ctx, need - file->num_clus, &len);
+
+        if (!first) return -1;
+
+        for (uint32_t i = 0; i + 1 < len; ++i)
+            FAT_set_entries(ctx, first + i, first + i + 1);
+        FAT_set_entries(ctx, first + len - 1, 0xFFFFFFFF);
+
+        FAT_set_entries(ctx, file->tail_clus, first);
+
+        if (FAT_extent_append(file, first, len)) return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * preallocates clusters for [offset, offset + len)
+ *  without changing the size of the file
+ */
+int FAT_fallocate(t_FATFile *file, size_t offset, size_t len){
+    return FAT_file_reserve(file, offset + len);
 }
 
 /**
@@ -741,24 +1369,22 @@ void FAT_allocate_cluster(t_FATContext *ctx, uint32_t _cluster){
  *  in the parent directory dir
  */
 void FAT_upd_entry(t_FATContext *ctx, t_FATFile *file){
-    bool eoc = false;
     t_ShortDirEntry entry;
-    uint32_t entry_num = 0;
-    do {
-        eoc = FAT_dir_entry(ctx, file->parent_clus, entry_num, &entry);
-        if (file->starting_clus == entry.first_cluster_low){
-            entry.file_size = file->size;
-            entry.last_access_date = FAT_get_date();
-            if (file->flags & FAT_FILE_WRITE){
-                entry.last_write_date = FAT_get_date();
-                entry.last_write_time = FAT_get_time();
-            }
-            size_t off = FAT_absolute_offset(ctx, file->parent_clus, entry_num * sizeof(entry), NULL);  
-            SAL_write(ctx->device, sizeof(entry), off, &entry);
-            return;
-        }
-        ++entry_num;
-    } while (!eoc);
+
+    if (file->dir_entry == (uint32_t)-1 || 
+        FAT_dir_entry(ctx, file->parent_clus, file->dir_entry, &entry) ||
+        entry.first_cluster_low != file->starting_clus)
+        return;
+
+    entry.file_size = file->size;
+    entry.last_access_date = FAT_get_date();
+    if (file->flags & FAT_FILE_WRITE){
+        entry.last_write_date = FAT_get_date();
+        entry.last_write_time = FAT_get_time();
+    }
+
+    size_t off = FAT_absolute_offset(ctx, file->parent_clus, file->dir_entry * sizeof(entry), NULL);  
+    SAL_write(ctx->device, sizeof(entry), off, &entry);
 }
 
 uint16_t FAT_get_date(){
@@ -802,6 +1428,18 @@ uint8_t FAT_conv_attrib(uint8_t vfsattrib){
 /* FUNCTIONS DEFINED BELOW THIS SUBHEADING ARE FOR THE VFS API */
 
 void FAT_unmount(t_FATContext *ctx){
+    FAT_flush(ctx);
+    SAL_sync(ctx->device);
+    kfree(ctx->fat);
+    kfree(ctx->fat_dirty);
+    kfree(ctx->free_map);
+
+    while (ctx->dir_indexes){
+        t_FATDirIndex *next = ctx->dir_indexes->next;
+        FAT_dir_index_destroy(ctx->dir_indexes);
+        ctx->dir_indexes = next;
+    }
+
     kfree(ctx);
 }
 
@@ -844,33 +1482,44 @@ void FAT_create(t_FATHandle *dir, const char *name, uint8_t attribs){
     };
 
     FAT_conv_fname(name, (char*)&entry.name);
+
+    /* a freed directory might have left its index behind */
+    FAT_dir_index_drop(dir->ctx, entry.first_cluster_low);
     FAT_write_entry(dir->ctx, dir->start_cluster, &entry);
 
     FAT_set_entries(dir->ctx, entry.first_cluster_low, 0xFFFFFFFF);
 
     if (attribs & FILE_ATTRIB_DIRECTORY)
         FAT_init_dir(dir->ctx, entry.first_cluster_low, dir->start_cluster);
+
+    FAT_flush(dir->ctx);
 }
 
 void FAT_remove(t_FATHandle *file){
     t_ShortDirEntry entry;
-    bool is_eoc = 
-        FAT_dir_entry(file->ctx, file->dir_cluster, 0, &entry);
+    uint32_t entry_num = FAT_file_entry(file, &entry);
 
-    char conv_fname[11];
-    FAT_conv_fname(file->name, conv_fname);
-    for (uint32_t i = 0; !is_eoc; ++i){
-        if (!memcmp(entry.name, conv_fname, 11)){
-            FAT_free_cluster_chain(file->ctx, entry.first_cluster_low);
-            size_t entry_off = i * sizeof(t_ShortDirEntry); 
-            size_t final_off = 
-                FAT_absolute_offset(file->ctx, file->dir_cluster, entry_off, NULL);
-            entry = (t_ShortDirEntry){0};
-            SAL_write(file->ctx->device, sizeof(t_ShortDirEntry), final_off, &entry);
-        }
+    if (entry_num == (uint32_t)-1) return;
+
+    if (entry.first_cluster_low)
+        FAT_free_cluster_chain(file->ctx, entry.first_cluster_low);
 
-        is_eoc = FAT_dir_entry(file->ctx, file->dir_cluster, i + 1, &entry);
+    size_t entry_off = entry_num * sizeof(t_ShortDirEntry); 
+    size_t final_off = 
+        FAT_absolute_offset(file->ctx, file->dir_cluster, entry_off, NULL);
+
+    /* mark as deleted, a zeroed entry would end the directory */
+    entry.name[0] = 0xE5;
+    SAL_write(file->ctx->device, sizeof(t_ShortDirEntry), final_off, &entry);
+
+    t_FATDirIndex *index = FAT_dir_index(file->ctx, file->dir_cluster);
+    if (index){
+        char conv_fname[11];
+        FAT_conv_fname(file->name, conv_fname);
+        FAT_dir_index_remove(index, (uint8_t*)conv_fname);
     }
+
+    FAT_flush(file->ctx);
 }
 
 t_FATFile *FAT_open(t_FATHandle *handle, uint8_t mode){
@@ -879,7 +1528,7 @@ t_FATFile *FAT_open(t_FATHandle *handle, uint8_t mode){
     size_t   file_size;
 
     t_ShortDirEntry entry;
-    FAT_file_entry(handle, &entry);
+    uint32_t entry_num = FAT_file_entry(handle, &entry);
     file_size = entry.file_size;
         
     t_FATFile *file = kmalloc(sizeof *file);
@@ -888,9 +1537,11 @@ t_FATFile *FAT_open(t_FATHandle *handle, uint8_t mode){
         *file = (t_FATFile){
             .starting_clus = starting_clus,
             .parent_clus   = parent_clus,
+            .dir_entry     = entry_num,
             .size          = file_size,
             .flags         = mode,
-            .ctx           = handle->ctx
+            .ctx           = handle->ctx,
+            .position      = mode & FAT_FILE_APPND ? file_size : 0
         };
 
     return file;
@@ -898,83 +1549,175 @@ t_FATFile *FAT_open(t_FATHandle *handle, uint8_t mode){
 
 void FAT_close(t_FATFile *file){
     FAT_upd_entry(file->ctx, file);
+    FAT_flush(file->ctx);
+    SAL_sync(file->ctx->device);
+
+    if (file->extents)
+        kfree(file->extents);
 
     kfree(file);
 }
 
+/* writes at the file position into clusters that are already reserved */
+static size_t FAT_write_reserved(t_FATFile *file, size_t len, const void *data){
+    t_FATContext *ctx = file->ctx;
+    size_t bytes_written = 0,
+           capacity = file->num_clus * ctx->bytes_p_clus;
+
+    if (file->position >= capacity) return 0;
+    if (len > capacity - file->position) len = capacity - file->position;
+
+    /* one device write per run of contiguous clusters */
+    while (bytes_written < len){
+        size_t contig,
+               full_off = FAT_file_offset(file, file->position, &contig),
+               write_len = len - bytes_written < contig ? len - bytes_written : contig;
+
+        if (!full_off) break;
+
+        SAL_write(ctx->device, write_len, full_off, (void*)data + bytes_written);
+        bytes_written  += write_len;
+        file->position += write_len;
+    }
+
+    if (file->position > file->size)
+        file->size = file->position;
+
+    return bytes_written;
+}
+
 size_t FAT_write(t_FATFile *file, size_t len, void *data){
-    if (!(file->flags & FAT_FILE_WRITE)) return 0;
+    if (!(file->flags & FAT_FILE_WRITE) || !len) return 0;
+
+    size_t end = file->position + len;
+
+    /* reserve the whole write up front, if space runs out write what fits */
+    FAT_file_reserve(file, end > file->size ? end : file->size);
+
+    return FAT_write_reserved(file, len, data);
+}
+
+size_t FAT_extend(t_FATFile *file, size_t size){
+    static uint8_t zero_buff[0x1000];
     t_FATContext *ctx = file->ctx;
-    size_t full_off = FAT_absolute_offset(ctx, file->starting_clus, file->size, NULL),
-           bytes_written = 0, 
-           bpc  = ctx->bytes_p_clus;
-
-    if (file->size && !(file->size % bpc))
-        FAT_allocate_cluster(ctx, file->starting_clus);
-
-    /* start on unaligned to cluster */
-    if (file->size % bpc){
-        size_t clust_off = file->size % bpc,
-               write_len = bpc - clust_off >= len ? len : bpc - clust_off;
-        SAL_write(ctx->device, write_len, full_off, data); 
-        bytes_written += write_len;
-        file->size    += write_len;
+
+    if (size <= file->size || !(file->flags & FAT_FILE_WRITE)) 
+        return file->size;
+
+    /* one contiguous run for the whole extension where possible */
+    if (FAT_file_reserve(file, size)){
+        size_t capacity = file->num_clus * ctx->bytes_p_clus;
+
+        if (capacity < size) size = capacity;
     }
 
-    while (len - bytes_written >= bpc){
-        FAT_allocate_cluster(ctx, file->starting_clus);
-        full_off = FAT_absolute_offset(ctx, file->starting_clus, file->size, NULL);
-        SAL_write(ctx->device, bpc, full_off, data + bytes_written); 
-        bytes_written += bpc;
-        file->size    += bpc;
+    /* stale data past the old end (and in the new clusters) has to go */
+    while (file->size < size){
+        size_t contig,
+               full_off = FAT_file_offset(file, file->size, &contig),
+               len = size - file->size;
+
+        if (!full_off) break;
+
+        if (len > contig) len = contig;
+        if (len > sizeof zero_buff) len = sizeof zero_buff;
+
+        SAL_write(ctx->device, len, full_off, zero_buff);
+        file->size += len;
     }
 
-    /* end on unaligned to cluster */
-    if (len - bytes_written){
-        if (file->size) FAT_allocate_cluster(ctx, file->starting_clus);
-        full_off = FAT_absolute_offset(ctx, file->starting_clus, file->size, NULL);
-        size_t copy_len = len - bytes_written;
-        SAL_write(ctx->device, copy_len, full_off, data + bytes_written);
-        bytes_written += copy_len;
-        file->size    += copy_len;
+    return file->size;
+}
+
+size_t FAT_writev(t_FATFile *file, const t_IOVec *iov, int iovcnt){
+    if (!(file->flags & FAT_FILE_WRITE)) return 0;
+
+    size_t total = 0, res = 0;
+    for (int i = 0; i < iovcnt; ++i)
+        total += iov[i].len;
+
+    size_t end = file->position + total;
+
+    /* one reservation for every buffer, so the run stays contiguous */
+    FAT_file_reserve(file, end > file->size ? end : file->size);
+
+    for (int i = 0; i < iovcnt; ++i){
+        size_t n = FAT_write_reserved(file, iov[i].len, iov[i].base);
+        res += n;
+
+        if (n < iov[i].len) break;
     }
 
-    return bytes_written;
+    return res;
 }
 
-size_t FAT_read(t_FATFile *file, size_t len, void *data){
-    if (!(file->flags & FAT_FILE_READ)) return 0;
+/**
+ * detects sequential reads and keeps the next clusters of the
+ *  chain in the block cache, the window grows while the file
+ *  keeps being read in order and collapses on a seek
+ */
+static void FAT_readahead(t_FATFile *file, size_t len){
     t_FATContext *ctx = file->ctx;
-    size_t full_off = FAT_absolute_offset(ctx, file->starting_clus, file->position, NULL),
-           bytes_read = 0, 
-           bpc  = ctx->bytes_p_clus;
-
-    /* start on unaligned to cluster */
-    if (file->position % bpc){
-        size_t clust_off = file->position % bpc,
-               read_len  = bpc - clust_off >= len ? len : bpc - clust_off;
-        SAL_read(ctx->device, read_len, full_off, data); 
-        bytes_read     += read_len;
-        file->position += read_len;
-        if (bytes_read > file->size) return bytes_read;
+    size_t bpc = ctx->bytes_p_clus;
+
+    if (file->position != file->ra_next){
+        file->ra_window = 0;
+        file->ra_end    = 0;
+        file->ra_next   = file->position + len;
+        return;
     }
 
-    while (len - bytes_read >= bpc){
-        full_off = FAT_absolute_offset(ctx, file->starting_clus, file->position, NULL);
-        SAL_read(ctx->device, bpc, full_off, data + bytes_read); 
-        bytes_read += bpc;
-        file->position += bpc;
-        if (bytes_read > file->size) return bytes_read;
+    file->ra_next = file->position + len;
+
+    if (!file->ra_window)
+        file->ra_window = FAT_READAHEAD_MIN;
+    else if (file->ra_window < FAT_READAHEAD_MAX)
+        file->ra_window *= 2;
+
+    size_t start = file->ra_end > file->position ? file->ra_end : file->position,
+           end   = file->ra_next + file->ra_window * bpc,
+           /* the window is in clusters, the cache only fits so many sectors */
+           max   = SAL_PREFETCH_MAX * ctx->device->sector_size;
+
+    start -= start % bpc;
+
+    if (end > start + max) end = start + max;
+    if (end > file->size)  end = file->size;
+
+    /* cluster by cluster since they need not be contiguous */
+    for (; start < end; start += bpc){
+        size_t off = FAT_file_offset(file, start, NULL);
+
+        if (!off) break;
+
+        SAL_prefetch(ctx->device, end - start < bpc ? end - start : bpc, off);
     }
 
-    /* end on unaligned to cluster */
-    if (len - bytes_read){
-        full_off = FAT_absolute_offset(ctx, file->starting_clus, file->position, NULL);
-        size_t read_len = len - bytes_read;
+    if (start > end) start = end;
+    if (start > file->ra_end) file->ra_end = start;
+}
+
+size_t FAT_read(t_FATFile *file, size_t len, void *data){
+    if (!(file->flags & FAT_FILE_READ)) return 0;
+    t_FATContext *ctx = file->ctx;
+    size_t bytes_read = 0;
+
+    if (file->position >= file->size) return 0;
+    if (len > file->size - file->position) len = file->size - file->position;
+
+    FAT_readahead(file, len);
+
+    /* one device read per run of contiguous clusters */
+    while (bytes_read < len){
+        size_t contig,
+               full_off = FAT_file_offset(file, file->position, &contig),
+               read_len = len - bytes_read < contig ? len - bytes_read : contig;
+
+        if (!full_off) break;
+
         SAL_read(ctx->device, read_len, full_off, data + bytes_read);
-        bytes_read += read_len;
+        bytes_read     += read_len;
         file->position += read_len;
-        if (bytes_read > file->size) return bytes_read;
     }
 
     return bytes_read;
@@ -1003,6 +1746,12 @@ const char *FAT_handle_name(t_FATHandle *handle){
     return handle->name; 
 }
 
+void FAT_release(t_FATHandle *handle){
+    /* the root handle lives in the context */
+    if (handle != &handle->ctx->root)
+        kfree(handle);
+}
+
 void FAT_file_stat(t_FATHandle *file, t_FileStat *out){
     t_ShortDirEntry entry;
     FAT_file_entry(file, &entry);
@@ -1039,6 +1788,9 @@ void FAT_init(){
         .f_NodeName = (void*)FAT_handle_name,
         .f_Stat     = (void*)FAT_file_stat,
         .f_Seek     = (void*)FAT_file_seek,
+        .f_Release  = (void*)FAT_release,
+        .f_WriteV   = (void*)FAT_writev,
+        .f_Extend   = (void*)FAT_extend,
     };
     VFS_register_fs(&driver);
 
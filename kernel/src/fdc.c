@@ -4,6 +4,7 @@
 #include <kernel/fdc.h>
 #include <kernel/irq.h>
 #include <kernel/pic.h>
+#include <kernel/pit.h>
 #include <kernel/pmm.h>
 #include <kernel/sal.h>
 #include <kernel/vmm.h>
@@ -11,8 +12,27 @@
 static bool floppy_irq_fired;
 
 uint8_t current_drive;
-void *buff_paddr;
-void *buff_vaddr;
+
+/* one whole cylinder (both heads) is read per dma transfer into here */
+static uint8_t *track_buff;
+static uint32_t track_paddr;
+
+static struct {
+    bool valid;
+    uint8_t drive;
+    uint8_t cylinder;
+    /**
+     * range of modified sectors (cylinder relative), written back in one
+     * command. clean sectors in between are valid too so they just get rewritten
+     */
+    int dirty_first;
+    int dirty_last;
+} track_cache = {.dirty_first = -1};
+
+static bool motor_on;
+static uint8_t motor_drive;
+/* tick at which the motor gets turned off, 0 = not armed */
+static volatile uint64_t motor_off_deadline;
 
 static bool drives_present[] = {[0] = false, [1] = false};
 
@@ -23,11 +43,17 @@ void FDC_set_drive(uint8_t drive) {
 
 static void FDC_lba_to_chs(uint32_t lba, uint8_t *head, uint8_t *cylinder,
                            uint8_t *sector) {
-    *head = (lba / FLOPPY_SECTORS_PER_TRACK) % 2;
-    *cylinder = (lba / FLOPPY_SECTORS_PER_TRACK) / 2;
+    *head = (lba / FLOPPY_SECTORS_PER_TRACK) % FLOPPY_HEADS;
+    *cylinder = (lba / FLOPPY_SECTORS_PER_TRACK) / FLOPPY_HEADS;
     *sector = lba % FLOPPY_SECTORS_PER_TRACK + 1;
 }
 
+/* offset of a sector inside the cylinder buffer */
+static size_t FDC_track_offset(uint8_t head, uint8_t sector) {
+    return (head * FLOPPY_SECTORS_PER_TRACK + sector - 1) *
+           FLOPPY_BYTES_PER_SECTOR;
+}
+
 static void FDC_enable() {
     port_write_byte(FDC_DOR,
                     current_drive | FDC_DOR_MASK_RESET | FDC_DOR_MASK_DMA);
@@ -66,16 +92,11 @@ static void FDC_irq_wait() {
     floppy_irq_fired = false;
 }
 
-static void FDC_DMA_init() {
-    DMA_set_mask(FLOPPY_CHANNEL, true);
-
-    DMA_reset_flipflop(0);
-    DMA_set_full_address(FLOPPY_CHANNEL, (uint32_t)buff_paddr);
-    DMA_reset_flipflop(0);
-
-    DMA_set_count(FLOPPY_CHANNEL, FLOPPY_BYTES_PER_SECTOR - 1);
-
-    DMA_set_mask(FLOPPY_CHANNEL, false);
+static void FDC_DMA_init(bool write, size_t offset, size_t len) {
+    DMA_setup_transfer(FLOPPY_CHANNEL, track_paddr + offset, len,
+                       (write ? DMA_MODE_WRITE_TRANSFER
+                              : DMA_MODE_READ_TRANSFER) |
+                           DMA_MODE_TRANSFER_SINGLE);
 }
 
 static int FDC_check_floppies() {
@@ -99,13 +120,20 @@ void FDC_init() {
     if (FDC_check_floppies())
         return;
 
+    track_buff = DMA_alloc(FLOPPY_BYTES_PER_CYLINDER, &track_paddr);
+    if (!track_buff) {
+        printf("FDC_init: no dma memory\n");
+        return;
+    }
+
     if (drives_present[0])
         SAL_add_device((storage_device_t){.maxlba = 2879,
                                           .sector_size = FLOPPY_BYTES_PER_SECTOR,
                                           .name = "Floppy Disk Drive 1",
                                           .drive_num = 0,
                                           .read_sector = FDC_read_sector,
-                                          .write_sector = FDC_write_sector});
+                                          .write_sector = FDC_write_sector,
+                                          .flush = FDC_flush});
 
     if (drives_present[1])
         SAL_add_device((storage_device_t){.maxlba = 2879,
@@ -113,69 +141,138 @@ void FDC_init() {
                                           .name = "Floppy Disk Drive 1",
                                           .drive_num = 1,
                                           .read_sector = FDC_read_sector,
-                                          .write_sector = FDC_write_sector});
-
-    buff_paddr = alloc_page();
-    if ((0xFFFFFF - (unsigned long)buff_paddr) < 4096)
-        return;
+                                          .write_sector = FDC_write_sector,
+                                          .flush = FDC_flush});
 
     current_drive = 0;
 
-    /* map the buffer so we can access it */
-    buff_vaddr = vmm_map_page(buff_paddr, buff_paddr + 0xC0000000, false);
-
-    memset(buff_vaddr, 'A', 4095);
+    PIT_add_tick_handler(FDC_motor_tick);
 
     PIC_unmask(FLOPPY_IRQ);
     FDC_set_drive(0);
     FDC_reset();
 }
 
-static void FDC_CMD_read_sector(uint8_t head, uint8_t track, uint8_t sector) {
-    FDC_DMA_init();
-    DMA_SET_READ(FLOPPY_CHANNEL);
+/**
+ * read/write sectors [sector, eot] of the cylinder (continuing on head 1 because
+ * of multitrack) from/to the track buffer at offset, dma count ends the transfer
+ */
+static int FDC_CMD_transfer(bool write, uint8_t head, uint8_t cylinder,
+                            uint8_t sector, uint8_t eot, size_t offset,
+                            size_t len) {
+    uint8_t st0, st1, st2;
 
-    FDC_write_cmd(FDC_CMD_READ_SECT | FDC_CMD_EXT_MULTITRACK | FDC_CMD_EXT_SKIP |
+    FDC_DMA_init(write, offset, len);
+
+    FDC_write_cmd((write ? FDC_CMD_WRITE_SECT : FDC_CMD_READ_SECT) |
+                  FDC_CMD_EXT_MULTITRACK | FDC_CMD_EXT_SKIP |
                   FDC_CMD_EXT_DENSITY);
 
     FDC_write_cmd(head << 2 | current_drive);
-    FDC_write_cmd(track);
+    FDC_write_cmd(cylinder);
     FDC_write_cmd(head);
     FDC_write_cmd(sector);
     FDC_write_cmd(FDC_CMD_DTL_512);
-    FDC_write_cmd(sector + 1 >= FLOPPY_SECTORS_PER_TRACK
-                      ? FLOPPY_SECTORS_PER_TRACK
-                      : sector + 1);
+    FDC_write_cmd(eot);
     FDC_write_cmd(FDC_CMD_GAP3_LENGTH_3_5);
     FDC_write_cmd(0xFF);
 
     FDC_irq_wait();
 
-    for (int i = 0; i < 7; ++i)
+    st0 = FDC_read_data();
+    st1 = FDC_read_data();
+    st2 = FDC_read_data();
+
+    /* C, H, R, N */
+    for (int i = 0; i < 4; ++i)
         FDC_read_data();
+
+    /* running off the end of the cylinder is how a full track read ends */
+    if ((st1 & ~FDC_ST1_END_OF_CYLINDER) || st2)
+        return -1;
+    if ((st0 & FDC_ST0_IC_MASK) && !(st1 & FDC_ST1_END_OF_CYLINDER))
+        return -1;
+
+    return 0;
 }
 
-static void FDC_CMD_write_sector(uint8_t head, uint8_t track, uint8_t sector) {
-    FDC_DMA_init();
-    DMA_SET_WRITE(FLOPPY_CHANNEL);
+/* write the dirty range of the cached cylinder back with one multitrack WRITE */
+static int FDC_flush_track() {
+    int first = track_cache.dirty_first, last = track_cache.dirty_last;
 
-    FDC_write_cmd(FDC_CMD_WRITE_SECT | FDC_CMD_EXT_MULTITRACK | FDC_CMD_EXT_SKIP |
-                  FDC_CMD_EXT_DENSITY);
-    FDC_write_cmd(head << 2 | current_drive);
-    FDC_write_cmd(track);
-    FDC_write_cmd(head);
-    FDC_write_cmd(sector);
-    FDC_write_cmd(FDC_CMD_DTL_512);
-    FDC_write_cmd(sector + 1 >= FLOPPY_SECTORS_PER_TRACK
-                      ? FLOPPY_SECTORS_PER_TRACK
-                      : sector + 1);
-    FDC_write_cmd(FDC_CMD_GAP3_LENGTH_3_5);
-    FDC_write_cmd(0xFF);
+    if (!track_cache.valid || first < 0)
+        return 0;
 
-    FDC_irq_wait();
+    uint8_t head = first / FLOPPY_SECTORS_PER_TRACK;
+    uint8_t sector = first % FLOPPY_SECTORS_PER_TRACK + 1;
+    int err = -1;
 
-    for (int i = 0; i < 7; ++i)
-        FDC_read_data();
+    current_drive = track_cache.drive;
+
+    for (int i = 0; i < FDC_RETRIES && err; ++i) {
+        FDC_start_motor(track_cache.drive);
+
+        if (FDC_CMD_seek(track_cache.cylinder, head) ||
+            FDC_CMD_transfer(true, head, track_cache.cylinder, sector,
+                             FLOPPY_SECTORS_PER_TRACK,
+                             first * FLOPPY_BYTES_PER_SECTOR,
+                             (last - first + 1) * FLOPPY_BYTES_PER_SECTOR)) {
+            FDC_CMD_callibrate(track_cache.drive);
+            continue;
+        }
+
+        err = 0;
+    }
+
+    FDC_schedule_motor_off();
+
+    if (err) {
+        printf("FDC_flush_track: failed to write cylinder %d\n",
+               track_cache.cylinder);
+        return -1;
+    }
+
+    track_cache.dirty_first = track_cache.dirty_last = -1;
+    return 0;
+}
+
+/* pull a whole cylinder into the track buffer */
+static int FDC_read_cylinder(uint8_t drive, uint8_t cylinder) {
+    /**
+     * the buffer is about to be overwritten, if the dirty sectors
+     *  can't be written keep them cached so a later flush can retry
+     */
+    if (FDC_flush_track())
+        return -1;
+
+    track_cache.valid = false;
+    track_cache.dirty_first = track_cache.dirty_last = -1;
+    current_drive = drive;
+
+    for (int i = 0; i < FDC_RETRIES; ++i) {
+        FDC_start_motor(drive);
+
+        if (FDC_CMD_seek(cylinder, 0) ||
+            FDC_CMD_transfer(false, 0, cylinder, 1, FLOPPY_SECTORS_PER_TRACK,
+                             0, FLOPPY_BYTES_PER_CYLINDER)) {
+            FDC_CMD_callibrate(drive);
+            continue;
+        }
+
+        track_cache.drive = drive;
+        track_cache.cylinder = cylinder;
+        track_cache.valid = true;
+        break;
+    }
+
+    FDC_schedule_motor_off();
+
+    return track_cache.valid ? 0 : -1;
+}
+
+static bool FDC_track_cached(uint8_t drive, uint8_t cylinder) {
+    return track_cache.valid && track_cache.drive == drive &&
+           track_cache.cylinder == cylinder;
 }
 
 void FDC_read_sector(storage_device_t *device, void *buff, uint32_t lba) {
@@ -185,32 +282,50 @@ void FDC_read_sector(storage_device_t *device, void *buff, uint32_t lba) {
 
     FDC_lba_to_chs(lba, &head, &cylinder, &sector);
 
-    FDC_start_motor(current_drive);
-
-    FDC_CMD_seek(cylinder, head);
-
-    FDC_CMD_read_sector(head, cylinder, sector);
-
-    FDC_stop_motor();
+    if (!FDC_track_cached(current_drive, cylinder) &&
+        FDC_read_cylinder(current_drive, cylinder)) {
+        printf("FDC_read_sector: failed to read cylinder %d\n", cylinder);
+        return;
+    }
 
-    memcpy(buff, (void *)buff_vaddr, FLOPPY_BYTES_PER_SECTOR);
+    memcpy(buff, track_buff + FDC_track_offset(head, sector),
+           FLOPPY_BYTES_PER_SECTOR);
 }
 
+/**
+ * writes only go into the track buffer (reading the cylinder in first if needed),
+ * they reach the disk on FDC_flush or once another cylinder gets cached
+ */
 void FDC_write_sector(storage_device_t *device, const void *buff,
                       uint32_t lba) {
     current_drive = device->drive_num;
 
-    memcpy((void *)buff_vaddr, buff, FLOPPY_BYTES_PER_SECTOR);
-
     uint8_t head, cylinder, sector;
 
     FDC_lba_to_chs(lba, &head, &cylinder, &sector);
 
-    FDC_start_motor(current_drive);
+    if (!FDC_track_cached(current_drive, cylinder) &&
+        FDC_read_cylinder(current_drive, cylinder)) {
+        printf("FDC_write_sector: failed to read cylinder %d\n", cylinder);
+        return;
+    }
 
-    FDC_CMD_seek(cylinder, head);
+    int index = head * FLOPPY_SECTORS_PER_TRACK + sector - 1;
 
-    FDC_CMD_write_sector(head, cylinder, sector);
+    memcpy(track_buff + FDC_track_offset(head, sector), buff,
+           FLOPPY_BYTES_PER_SECTOR);
+
+    if (track_cache.dirty_first < 0 || index < track_cache.dirty_first)
+        track_cache.dirty_first = index;
+    if (index > track_cache.dirty_last)
+        track_cache.dirty_last = index;
+}
+
+int FDC_flush(storage_device_t *device) {
+    if (track_cache.drive != device->drive_num)
+        return 0;
+
+    return FDC_flush_track();
 }
 
 static void FDC_CMD_specify(uint32_t stepr, uint32_t loadt, uint32_t unloadt,
@@ -240,13 +355,13 @@ static int FDC_CMD_callibrate(uint8_t drive) {
         FDC_check_int(&st0, &cyl);
 
         if (cyl == 0) {
-            FDC_stop_motor();
+            FDC_schedule_motor_off();
             return 0;
         }
     }
 
     printf("FDC_CMD_callibrate: status = fuck\n");
-    FDC_stop_motor();
+    FDC_schedule_motor_off();
     return -1;
 }
 
@@ -304,6 +419,12 @@ static void FDC_check_int(uint8_t *st0, uint8_t *cylinder) {
 }
 
 static void FDC_start_motor(uint8_t drive) {
+    /* disarm the timeout, the motor has to stay on during the command */
+    motor_off_deadline = 0;
+
+    if (motor_on && motor_drive == drive)
+        return;
+
     switch (drive) {
     case 0:
         port_write_byte(FDC_DOR, current_drive | FDC_DOR_MASK_DRIVE0_MOTOR |
@@ -323,8 +444,26 @@ static void FDC_start_motor(uint8_t drive) {
         break;
     }
 
+    motor_on = true;
+    motor_drive = drive;
+
     /* give motor time to start up */
     // PIT_sleep(50);
 }
 
-static void FDC_stop_motor() { port_write_byte(FDC_DOR, FDC_DOR_MASK_RESET); }
+static void FDC_stop_motor() {
+    motor_off_deadline = 0;
+    motor_on = false;
+
+    port_write_byte(FDC_DOR, FDC_DOR_MASK_RESET);
+}
+
+/* keep spinning for a while, the next access is likely close by */
+static void FDC_schedule_motor_off() {
+    motor_off_deadline = PIT_ticks() + FDC_MOTOR_TIMEOUT_MS;
+}
+
+static void FDC_motor_tick(uint64_t ticks) {
+    if (motor_off_deadline && ticks >= motor_off_deadline)
+        FDC_stop_motor();
+}
@@ -45,4 +45,26 @@ void port_write_slow_byte(uint16_t port, uint8_t data){
 
 void io_wait(){
     port_write_byte(UNUSED_PORT, 0);    
-}
\ No newline at end of file
+}
+uint64_t msr_read(uint32_t msr){
+    uint32_t lo, hi;
+    asm volatile("rdmsr" : "=a" (lo), "=d" (hi) : "c" (msr));
+    return (uint64_t) hi << 32 | lo;
+}
+
+void msr_write(uint32_t msr, uint64_t value){
+    asm volatile("wrmsr" : : "c" (msr), "a" ((uint32_t) value), "d" ((uint32_t) (value >> 32)));
+}
+
+void cpu_id(uint32_t leaf, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx){
+    asm volatile("cpuid"
+        : "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx)
+        : "a" (leaf), "c" (0)
+    );
+}
+
+uint64_t cpu_tsc(){
+    uint32_t lo, hi;
+    asm volatile("rdtsc" : "=a" (lo), "=d" (hi));
+    return (uint64_t) hi << 32 | lo;
+}
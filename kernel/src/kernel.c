@@ -6,6 +6,7 @@
 #include <kernel/irq.h>
 #include <kernel/isr.h>
 #include <kernel/kmm.h>
+#include <kernel/pgc.h>
 #include <kernel/pit.h>
 #include <kernel/pmm.h>
 #include <kernel/rtc.h>
@@ -14,12 +15,16 @@
 #include <kernel/tty.h>
 #include <kernel/vfm.h>
 #include <kernel/dev.h>
+#include <kernel/vdso.h>
 #include <kernel/vfs.h>
 #include <kernel/vmm.h>
 #include <kernel/sys.h>
+#include <kernel/bench.h>
 #include <stdio.h>
+#include <string.h>
 
 void kernel_main() {
+    mem_init();
     terminal_init();
     printf("Loading TSS...");
     TSS_init();
@@ -33,6 +38,9 @@ void kernel_main() {
     printf("Loading ISR...");
     ISR_init();
     printf("ISR Loaded!\n");
+    printf("Loading SYS...");
+    SYS_init();
+    printf("SYS Loaded!\n");
     printf("Loading IRQ...");
     IRQ_init();
     printf("IRQ Loaded!\n");
@@ -51,6 +59,12 @@ void kernel_main() {
     printf("Loading KMM...");
     KMM_init();
     printf("KMM Loaded!\n");
+    printf("Loading PGC...");
+    PGC_init();
+    printf("PGC Loaded!\n");
+    printf("Loading VDSO...");
+    VDSO_init();
+    printf("VDSO Loaded!\n");
     printf("Loading SAL...");
     SAL_init();
     printf("SAL Loaded!\n");
@@ -77,5 +91,10 @@ void kernel_main() {
     printf("The time is %d:%d:%d\n", time.hours, time.minutes, time.seconds);
 
     printf("Welcome to lakeOS!\n");
+
+#ifdef BENCH
+    BENCH_mem();
+#endif
+
     sys_exec("/INIT.ELF", 0, NULL);
 }
@@ -0,0 +1,233 @@
+#define _VFS_H_INTERNAL
+#include <kernel/pgc.h>
+#include <kernel/pmm.h>
+#include <kernel/vmm.h>
+#include <string.h>
+
+static t_PGCPage  pages[PGC_PAGES];
+static t_PGCPage *buckets[PGC_BUCKETS];
+/* head is the most recently used page, free pages sit at the tail */
+static t_PGCPage *lru_head, *lru_tail;
+
+static uint32_t PGC_hash(t_VFSNode *vnode, uint32_t index){
+    return (((uint32_t)vnode >> 4) ^ (index * 2654435761u)) % PGC_BUCKETS;
+}
+
+static void PGC_lru_unlink(t_PGCPage *page){
+    if (page->lru_prev) page->lru_prev->lru_next = page->lru_next;
+    else                lru_head = page->lru_next;
+
+    if (page->lru_next) page->lru_next->lru_prev = page->lru_prev;
+    else                lru_tail = page->lru_prev;
+}
+
+static void PGC_lru_push(t_PGCPage *page){
+    page->lru_prev = NULL;
+    page->lru_next = lru_head;
+
+    if (lru_head) lru_head->lru_prev = page;
+    else          lru_tail = page;
+
+    lru_head = page;
+}
+
+static void PGC_lru_push_tail(t_PGCPage *page){
+    page->lru_next = NULL;
+    page->lru_prev = lru_tail;
+
+    if (lru_tail) lru_tail->lru_next = page;
+    else          lru_head = page;
+
+    lru_tail = page;
+}
+
+static void PGC_unhash(t_PGCPage *page){
+    t_PGCPage **link = &buckets[PGC_hash(page->vnode, page->index)];
+
+    while (*link && *link != page)
+        link = &(*link)->hash_next;
+
+    if (*link) *link = page->hash_next;
+
+    page->vnode = NULL;
+}
+
+void PGC_init(){
+    for (int i = 0; i < PGC_PAGES; ++i){
+        void *vaddr = (void*)(PGC_VADDR + i * PAGE_SIZE),
+             *paddr = alloc_page();
+
+        vmm_map_page(paddr, vaddr, true, false);
+
+        pages[i] = (t_PGCPage){ .data = vaddr, .paddr = paddr };
+        PGC_lru_push(pages + i);
+    }
+}
+
+static t_PGCPage *PGC_lookup(t_VFSNode *vnode, uint32_t index){
+    t_PGCPage *page = buckets[PGC_hash(vnode, index)];
+
+    while (page && !(page->vnode == vnode && page->index == index))
+        page = page->hash_next;
+
+    return page;
+}
+
+t_PGCPage *PGC_find(t_FileDescriptor *file, uint32_t index){
+    return PGC_lookup(file->vnode, index);
+}
+
+/* the least recently used page nobody has mapped */
+static t_PGCPage *PGC_victim(){
+    t_PGCPage *page = lru_tail;
+
+    while (page && page->maps)
+        page = page->lru_prev;
+
+    if (page && page->vnode)
+        PGC_unhash(page);
+
+    return page;
+}
+
+static void PGC_fill(t_PGCPage *page, t_FileDescriptor *file){
+    t_VFSOperations *ops = file->driver;
+    size_t pos = ops->f_Seek(file->descriptor, -1);
+
+    ops->f_Seek(file->descriptor, page->index * PAGE_SIZE);
+    page->valid = ops->f_Read(file->descriptor, PAGE_SIZE, page->data);
+    ops->f_Seek(file->descriptor, pos);
+
+    /* mappings see zeroes past the end of the file */
+    memset(page->data + page->valid, 0, PAGE_SIZE - page->valid);
+}
+
+/* finds or reads in the page, NULL if the cache is full of mapped pages */
+static t_PGCPage *PGC_get(t_FileDescriptor *file, uint32_t index){
+    t_PGCPage *page = PGC_lookup(file->vnode, index);
+
+    if (page){
+        PGC_lru_unlink(page);
+        PGC_lru_push(page);
+        return page;
+    }
+
+    page = PGC_victim();
+    if (!page) return NULL;
+
+    uint32_t bucket = PGC_hash(file->vnode, index);
+
+    page->vnode     = file->vnode;
+    page->index     = index;
+    page->hash_next = buckets[bucket];
+    buckets[bucket] = page;
+
+    PGC_fill(page, file);
+
+    PGC_lru_unlink(page);
+    PGC_lru_push(page);
+
+    return page;
+}
+
+size_t PGC_read(t_FileDescriptor *file, size_t pos, size_t len, void *buff){
+    size_t done = 0;
+
+    while (done < len){
+        t_PGCPage *page = PGC_get(file, pos / PAGE_SIZE);
+
+        /* nothing left to evict, go around the cache */
+        if (!page){
+            t_VFSOperations *ops = file->driver;
+
+            ops->f_Seek(file->descriptor, pos);
+            return done + ops->f_Read(file->descriptor, len - done, buff + done);
+        }
+
+        size_t off = pos % PAGE_SIZE;
+        if (off >= page->valid) break;
+
+        size_t n = page->valid - off;
+        if (n > len - done) n = len - done;
+
+        memcpy(buff + done, page->data + off, n);
+        done += n;
+        pos  += n;
+
+        /* a partial page is the end of the file */
+        if (page->valid < PAGE_SIZE) break;
+    }
+
+    return done;
+}
+
+void PGC_update(t_VFSNode *vnode, size_t pos, size_t len, const void *buff){
+    size_t end = pos + len;
+
+    while (pos < end){
+        size_t off = pos % PAGE_SIZE,
+               n   = PAGE_SIZE - off;
+
+        if (n > end - pos) n = end - pos;
+
+        t_PGCPage *page = PGC_lookup(vnode, pos / PAGE_SIZE);
+
+        if (page){
+            /* anything between valid and off is still zeroed from the fill */
+            memcpy(page->data + off, buff, n);
+
+            if (off + n > page->valid)
+                page->valid = off + n;
+        }
+
+        pos  += n;
+        buff += n;
+    }
+}
+
+void PGC_extend(t_VFSNode *vnode, size_t size){
+    for (int i = 0; i < PGC_PAGES; ++i){
+        t_PGCPage *page = pages + i;
+
+        if (page->vnode != vnode) continue;
+
+        size_t start = page->index * PAGE_SIZE;
+        if (size <= start) continue;
+
+        size_t valid = size - start < PAGE_SIZE ? size - start : PAGE_SIZE;
+        if (valid > page->valid) page->valid = valid;
+    }
+}
+
+void PGC_invalidate(t_VFSNode *vnode){
+    for (int i = 0; i < PGC_PAGES; ++i){
+        t_PGCPage *page = pages + i;
+
+        if (page->vnode != vnode || page->maps) continue;
+
+        PGC_unhash(page);
+        PGC_lru_unlink(page);
+        PGC_lru_push_tail(page);
+    }
+}
+
+t_PGCPage *PGC_map(t_FileDescriptor *file, uint32_t index){
+    t_PGCPage *page = PGC_get(file, index);
+
+    if (page) ++page->maps;
+
+    return page;
+}
+
+void PGC_unmap(t_PGCPage *page){
+    if (page->maps) --page->maps;
+}
+
+void PGC_writeback(t_PGCPage *page, t_FileDescriptor *file){
+    t_VFSOperations *ops = file->driver;
+    size_t pos = ops->f_Seek(file->descriptor, -1);
+
+    ops->f_Seek(file->descriptor, page->index * PAGE_SIZE);
+    ops->f_Write(file->descriptor, page->valid, page->data);
+    ops->f_Seek(file->descriptor, pos);
+}
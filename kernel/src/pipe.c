@@ -0,0 +1,133 @@
+#include <kernel/pipe.h>
+#include <kernel/kmm.h>
+#include <string.h>
+#include <stdlib.h>
+
+t_VFSOperations pipe_vfs_ops = (t_VFSOperations){
+    .f_Read     = (void*) PIPE_read,
+    .f_Write    = (void*) PIPE_write,
+    .f_Close    = (void*) PIPE_close,
+    .f_Stat     = (void*) PIPE_fstat,
+    /* pipes can't seek, which also keeps them out of the page cache */
+    .f_Seek     = NULL,
+};
+
+static void PIPE_sleep(t_WaitQueue *queue){
+    ++queue->waiters;
+    asm volatile("sti\n"
+                 "hlt\n" ::: "memory");
+    --queue->waiters;
+}
+
+int PIPE_create(t_PipeEnd **out_read, t_PipeEnd **out_write){
+    t_Pipe    *pipe = kmalloc(sizeof *pipe);
+    t_PipeEnd *read = kmalloc(sizeof *read),
+              *write = kmalloc(sizeof *write);
+
+    if (!pipe || !read || !write){
+        if (pipe)  kfree(pipe);
+        if (read)  kfree(read);
+        if (write) kfree(write);
+        return -1;
+    }
+
+    pipe->head = pipe->tail = 0;
+    pipe->readers = pipe->writers = 1;
+    pipe->read_queue = pipe->write_queue = (t_WaitQueue){ 0 };
+
+    *read  = (t_PipeEnd){ .pipe = pipe, .write = false };
+    *write = (t_PipeEnd){ .pipe = pipe, .write = true };
+
+    *out_read  = read;
+    *out_write = write;
+    return 0;
+}
+
+size_t PIPE_read(t_PipeEnd *end, size_t bytes, void *buff){
+    t_Pipe *pipe = end->pipe;
+    if (end->write || !bytes) return 0;
+
+    uint32_t tail = pipe->tail,
+             head;
+
+    /* acquire pairs with the writer's release, the data is there before head */
+    while ((head = __atomic_load_n(&pipe->head, __ATOMIC_ACQUIRE)) == tail){
+        if (!__atomic_load_n(&pipe->writers, __ATOMIC_ACQUIRE))
+            return 0;
+
+        PIPE_sleep(&pipe->read_queue);
+    }
+
+    size_t avail = head - tail;
+    if (bytes > avail) bytes = avail;
+
+    /* at most two copies, before and after the wrap */
+    size_t off   = tail & (PIPE_SIZE - 1),
+           first = PIPE_SIZE - off < bytes ? PIPE_SIZE - off : bytes;
+
+    memcpy(buff, pipe->buff + off, first);
+    memcpy(buff + first, pipe->buff, bytes - first);
+
+    __atomic_store_n(&pipe->tail, tail + bytes, __ATOMIC_RELEASE);
+
+    return bytes;
+}
+
+size_t PIPE_write(t_PipeEnd *end, size_t bytes, const void *buff){
+    t_Pipe *pipe = end->pipe;
+    if (!end->write) return 0;
+
+    size_t done = 0;
+
+    while (done < bytes){
+        if (!__atomic_load_n(&pipe->readers, __ATOMIC_ACQUIRE))
+            return done ? done : (size_t)-1;
+
+        uint32_t head = pipe->head,
+                 tail = __atomic_load_n(&pipe->tail, __ATOMIC_ACQUIRE);
+
+        size_t space = PIPE_SIZE - (head - tail);
+
+        if (!space){
+            PIPE_sleep(&pipe->write_queue);
+            continue;
+        }
+
+        size_t n = bytes - done < space ? bytes - done : space;
+
+        size_t off   = head & (PIPE_SIZE - 1),
+               first = PIPE_SIZE - off < n ? PIPE_SIZE - off : n;
+
+        memcpy(pipe->buff + off, buff + done, first);
+        memcpy(pipe->buff, buff + done + first, n - first);
+
+        /* publish the bytes only after they are copied in */
+        __atomic_store_n(&pipe->head, head + n, __ATOMIC_RELEASE);
+        done += n;
+    }
+
+    return done;
+}
+
+void PIPE_close(t_PipeEnd *end){
+    t_Pipe *pipe = end->pipe;
+
+    if (end->write) __atomic_sub_fetch(&pipe->writers, 1, __ATOMIC_RELEASE);
+    else            __atomic_sub_fetch(&pipe->readers, 1, __ATOMIC_RELEASE);
+
+    if (!pipe->readers && !pipe->writers)
+        kfree(pipe);
+
+    kfree(end);
+}
+
+void PIPE_fstat(t_PipeEnd *end, t_FileStat *out){
+    VFS_curr_chrono(&out->modified);
+
+    *out = (t_FileStat){
+        .created  = out->modified,
+        .modified = out->modified,
+        .size     = end->pipe->head - end->pipe->tail,
+        .flags    = 0
+    };
+}
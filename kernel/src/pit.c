@@ -1,5 +1,6 @@
 #include <kernel/pit.h>
 #include <kernel/rtc.h>
+#include <kernel/vdso.h>
 #include <stdlib.h>
 
 #define TIMER_IRQ 0x0
@@ -20,6 +21,26 @@ void PIT_set_freq(int hz){
 static bool carry_over;
 static uint64_t ticks;
 
+#define PIT_MAX_TICK_HANDLERS 8
+
+static PIT_tick_handler_t tick_handlers[PIT_MAX_TICK_HANDLERS];
+static int num_tick_handlers;
+
+/**
+ * register a function to be called from the timer irq on every tick,
+ * meant for cheap deadline checks (motor timeouts etc.), dont do io in there
+ */
+int PIT_add_tick_handler(PIT_tick_handler_t handler){
+    if (num_tick_handlers == PIT_MAX_TICK_HANDLERS) return -1;
+
+    tick_handlers[num_tick_handlers++] = handler;
+    return 0;
+}
+
+uint64_t PIT_ticks(){
+    return ticks;
+}
+
 uint16_t inc_unit_of_time(uint16_t unit, uint16_t max){
     if (unit == max){
         carry_over = true;
@@ -58,13 +79,19 @@ void IRQ_time_handler(){
     ++ticks;
     PIC_end_of_int(TIMER_IRQ);
 
-    if (ticks % 1000) return;
+    for (int i = 0; i < num_tick_handlers; ++i)
+        tick_handlers[i](ticks);
+
+    if (!(ticks % 1000)){
+        time.seconds = inc_unit_of_time(time.seconds, 59);
+        if (carry_over) time.minutes = inc_unit_of_time(time.minutes, 59);
+        if (carry_over) time.hours = inc_unit_of_time(time.hours, 23);
+        if (carry_over) inc_day_and_month(time.year, &time.month, &time.monthday);
+        if (carry_over) time.year = inc_unit_of_time(time.year, -1);
+    }
 
-    time.seconds = inc_unit_of_time(time.seconds, 59);
-    if (carry_over) time.minutes = inc_unit_of_time(time.minutes, 59);
-    if (carry_over) time.hours = inc_unit_of_time(time.hours, 23);
-    if (carry_over) inc_day_and_month(time.year, &time.month, &time.monthday);
-    if (carry_over) time.year = inc_unit_of_time(time.year, -1);
+    /* after the clock moved, so the page never shows a stale second */
+    VDSO_update(ticks);
 }
 
 void PIT_sleep(uint64_t ms){
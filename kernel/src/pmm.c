@@ -39,6 +39,38 @@ static void shrink_region_around_kernel(mmap_entry_t *region) {
     }
 }
 
+static void *dma_pool;
+
+/* skips the first bank, 0 is not a valid pointer to hand out */
+static void reserve_dma_pool() {
+    size_t pool_blocks = PMM_DMA_POOL_SIZE / MEMORY_BLOCK_SIZE;
+    size_t end = PMM_DMA_ZONE_END / MEMORY_BLOCK_SIZE;
+
+    if (end > bitmap_len)
+        end = bitmap_len;
+
+    for (size_t block_num = PMM_DMA_POOL_ALIGN / MEMORY_BLOCK_SIZE;
+         block_num + pool_blocks <= end;
+         block_num += PMM_DMA_POOL_ALIGN / MEMORY_BLOCK_SIZE) {
+        size_t i = 0;
+
+        while (i < pool_blocks &&
+               bitmap_getblockstate(block_num + i) == BITMAP_BLOCK_FREE)
+            ++i;
+
+        if (i < pool_blocks)
+            continue;
+
+        for (i = 0; i < pool_blocks; ++i)
+            bitmap_setblockstate(block_num + i, BITMAP_BLOCK_USED);
+
+        dma_pool = (void *)(block_num * MEMORY_BLOCK_SIZE);
+        return;
+    }
+}
+
+void *PMM_dma_pool() { return dma_pool; }
+
 void PMM_init() {
     mmap_entry_t *regions = (mmap_entry_t *)multiboot_info->mmap_addr;
     size_t num_regions = multiboot_info->mmap_length / sizeof(mmap_entry_t);
@@ -98,6 +130,8 @@ void PMM_init() {
                 else
                     regions[i].length_low = MEMORY_BLOCK_SIZE;
     }
+
+    reserve_dma_pool();
 }
 
 static size_t last_freed_block;
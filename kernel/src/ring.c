@@ -0,0 +1,83 @@
+#include <kernel/ring.h>
+#include <kernel/exe.h>
+#include <kernel/sys.h>
+
+t_Ring *RING_setup(t_Process *process){
+    if (process->ring) return process->ring;
+
+    t_Ring *ring = 
+        ualloc_pages(
+            process, RING_SIZE, 
+            UMM_BLOCK_PROT_READ | UMM_BLOCK_PROT_WRITE, 
+            UMM_BLOCK_FLAG_PRIVATE | UMM_BLOCK_FLAG_ANONYMOUS
+        );
+
+    /* anonymous pages come zeroed */
+    if (!ring) return NULL;
+
+    ring->entries = RING_ENTRIES;
+
+    return process->ring = ring;
+}
+
+static bool RING_batchable(uint32_t opcode){
+    switch (opcode){
+        case SYSCALL_READ:
+        case SYSCALL_WRITE:
+        case SYSCALL_OPEN:
+        case SYSCALL_CLOSE:
+        case SYSCALL_LSEEK:
+        case SYSCALL_PREAD:
+        case SYSCALL_PWRITE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+int RING_enter(t_Process *process, uint32_t count){
+    t_Ring *ring = process->ring;
+
+    /* the process could have unmapped it */
+    if (!ring || !umm_find_block(process, ring))
+        return -1;
+
+    uint32_t sq_head = ring->sq_head,
+             sq_tail = __atomic_load_n(&ring->sq_tail, __ATOMIC_ACQUIRE),
+             cq_tail = ring->cq_tail,
+             done    = 0;
+
+    /* the process owns sq_tail, don't trust it further than the ring */
+    if (sq_tail - sq_head > RING_ENTRIES)
+        return -1;
+
+    if (count > sq_tail - sq_head)
+        count = sq_tail - sq_head;
+
+    while (done < count){
+        uint32_t cq_head = __atomic_load_n(&ring->cq_head, __ATOMIC_ACQUIRE);
+        if (cq_tail - cq_head >= RING_ENTRIES) break;
+
+        /* copied out, the process may rewrite the slot as soon as sq_head moves */
+        t_RingSubmission sqe = ring->sq[sq_head % RING_ENTRIES];
+
+        uint32_t res = 
+            RING_batchable(sqe.opcode) 
+                ? SYS_dispatch(sqe.opcode, sqe.args[0], sqe.args[1], sqe.args[2], sqe.args[3], 0, 0)
+                : (uint32_t) -1;
+
+        ring->cq[cq_tail % RING_ENTRIES] = (t_RingCompletion){
+            .user_data = sqe.user_data,
+            .res       = res
+        };
+
+        ++sq_head;
+        ++cq_tail;
+        ++done;
+
+        __atomic_store_n(&ring->sq_head, sq_head, __ATOMIC_RELEASE);
+        __atomic_store_n(&ring->cq_tail, cq_tail, __ATOMIC_RELEASE);
+    }
+
+    return done;
+}
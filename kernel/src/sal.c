@@ -2,8 +2,196 @@
 #define _ATA_H_INTERNAL
 #include <kernel/sal.h>
 #include <kernel/kmm.h>
+#include <kernel/pit.h>
+#include <stdlib.h>
 #include <string.h>
 
+/**
+ * BLOCK CACHE
+ * 
+ * sectors are kept in a small hashed cache with an lru list, everything
+ *  going through SAL_read/SAL_write hits it first. writes only modify
+ *  the cached copy and mark it dirty, so repeated partial writes to the
+ *  same sector are combined. dirty sectors reach the device when they
+ *  get evicted, on SAL_sync, or once the writeback timer expires
+ */
+
+typedef struct t_SALBlock t_SALBlock;
+
+struct t_SALBlock {
+    storage_device_t *device;
+    uint32_t          lba;
+    t_SALBlock       *hash_next;
+    t_SALBlock       *lru_prev, 
+                     *lru_next;
+    bool              dirty;
+    uint8_t          *data;
+};
+
+static t_SALBlock  cache_blocks[SAL_CACHE_BLOCKS];
+static uint8_t     cache_data[SAL_CACHE_BLOCKS][SAL_CACHE_SECTOR_SIZE];
+static t_SALBlock *cache_buckets[SAL_CACHE_BUCKETS];
+
+/* head is the most recently used block, tail gets recycled */
+static t_SALBlock *lru_head, *lru_tail;
+
+static uint32_t num_dirty;
+/* set by the timer, io cant be done from the irq so it is checked on entry */
+static volatile bool writeback_due;
+
+#define SAL_HASH(device, lba) \
+    ((((uint32_t)(device) >> 4) ^ (lba)) % SAL_CACHE_BUCKETS)
+
+#define SAL_CACHEABLE(device) ((device)->sector_size <= SAL_CACHE_SECTOR_SIZE)
+
+static void SAL_lru_unlink(t_SALBlock *block){
+    if (block->lru_prev) block->lru_prev->lru_next = block->lru_next;
+    else                 lru_head = block->lru_next;
+
+    if (block->lru_next) block->lru_next->lru_prev = block->lru_prev;
+    else                 lru_tail = block->lru_prev;
+}
+
+static void SAL_lru_push(t_SALBlock *block){
+    block->lru_prev = NULL;
+    block->lru_next = lru_head;
+
+    if (lru_head) lru_head->lru_prev = block;
+    else          lru_tail = block;
+
+    lru_head = block;
+}
+
+static void SAL_hash_remove(t_SALBlock *block){
+    t_SALBlock **link = &cache_buckets[SAL_HASH(block->device, block->lba)];
+
+    while (*link && *link != block)
+        link = &(*link)->hash_next;
+
+    if (*link) *link = block->hash_next;
+}
+
+static t_SALBlock *SAL_cache_lookup(storage_device_t *device, uint32_t lba){
+    t_SALBlock *block = cache_buckets[SAL_HASH(device, lba)];
+
+    while (block && !(block->device == device && block->lba == lba))
+        block = block->hash_next;
+
+    return block;
+}
+
+static void SAL_block_writeback(t_SALBlock *block){
+    block->device->write_sector(block->device, block->data, block->lba);
+    block->dirty = false;
+    --num_dirty;
+}
+
+static void SAL_block_dirty(t_SALBlock *block){
+    if (block->dirty) return;
+
+    block->dirty = true;
+    ++num_dirty;
+}
+
+/**
+ * writes back the dirty blocks of device (all devices if NULL)
+ *  in ascending lba order so the drive doesnt seek back and forth
+ */
+static void SAL_writeback(storage_device_t *device){
+    t_SALBlock *dirty[SAL_CACHE_BLOCKS];
+    int n = 0;
+
+    if (!num_dirty) return;
+
+    for (int i = 0; i < SAL_CACHE_BLOCKS; ++i){
+        t_SALBlock *block = cache_blocks + i;
+
+        if (!block->dirty || (device && block->device != device))
+            continue;
+
+        int j = n++;
+        for (; j > 0 && dirty[j - 1]->lba > block->lba; --j)
+            dirty[j] = dirty[j - 1];
+        dirty[j] = block;
+    }
+
+    for (int i = 0; i < n; ++i)
+        SAL_block_writeback(dirty[i]);
+}
+
+static void SAL_writeback_tick(uint64_t ticks){
+    if (num_dirty && !(ticks % SAL_WRITEBACK_INTERVAL_MS))
+        writeback_due = true;
+}
+
+static void SAL_check_writeback(){
+    if (!writeback_due) return;
+
+    writeback_due = false;
+    SAL_writeback(NULL);
+}
+
+/**
+ * returns the cached block for lba, recycling the least recently
+ *  used one if it isnt cached yet, the block is read from the
+ *  device if fill is set
+ */
+static t_SALBlock *SAL_cache_get(storage_device_t *device, uint32_t lba, bool fill){
+    t_SALBlock *block = SAL_cache_lookup(device, lba);
+
+    if (block){
+        SAL_lru_unlink(block);
+        SAL_lru_push(block);
+        return block;
+    }
+
+    block = lru_tail;
+
+    if (block->dirty)
+        SAL_block_writeback(block);
+
+    if (block->device)
+        SAL_hash_remove(block);
+
+    block->device = device;
+    block->lba    = lba;
+
+    uint32_t bucket   = SAL_HASH(device, lba);
+    block->hash_next      = cache_buckets[bucket];
+    cache_buckets[bucket] = block;
+
+    SAL_lru_unlink(block);
+    SAL_lru_push(block);
+
+    if (fill)
+        device->read_sector(device, block->data, lba);
+
+    return block;
+}
+
+/* reads a whole sector, through the cache if possible */
+static void SAL_read_sector(storage_device_t *device, void *buff, uint32_t lba){
+    if (!SAL_CACHEABLE(device)){
+        device->read_sector(device, buff, lba);
+        return;
+    }
+
+    memcpy(buff, SAL_cache_get(device, lba, true)->data, device->sector_size);
+}
+
+/* replaces a whole sector, no need to read it in first */
+static void SAL_write_sector(storage_device_t *device, const void *buff, uint32_t lba){
+    if (!SAL_CACHEABLE(device)){
+        device->write_sector(device, buff, lba);
+        return;
+    }
+
+    t_SALBlock *block = SAL_cache_get(device, lba, false);
+
+    memcpy(block->data, buff, device->sector_size);
+    SAL_block_dirty(block);
+}
+
 /*
 writes data to offset of sector
 assumes:
@@ -17,12 +205,21 @@ void SAL_write_unaligned (
     static uint8_t temp_buff[4096];
 
     if (4096 < device->sector_size) return;
+
+    /* patch the cached sector in place, it gets written out later */
+    if (SAL_CACHEABLE(device)){
+        t_SALBlock *block = SAL_cache_get(device, lba, true);
+
+        memcpy(block->data + sector_off, buff, len);
+        SAL_block_dirty(block);
+        return;
+    }
     
     device->read_sector(device, temp_buff, lba);
 
     memcpy(temp_buff + sector_off, buff, len);
 
-    device->write_sector(device,temp_buff, lba);
+    device->write_sector(device, temp_buff, lba);
 }
 
 /*
@@ -39,6 +236,11 @@ void SAL_read_unaligned (
 
     if (4096 < device->sector_size) return;
     
+    if (SAL_CACHEABLE(device)){
+        memcpy(buff, SAL_cache_get(device, lba, true)->data + sector_off, len);
+        return;
+    }
+
     device->read_sector(device, temp_buff, lba);
 
     memcpy(buff, temp_buff + sector_off, len);
@@ -52,9 +254,11 @@ void SAL_read (storage_device_t *device, size_t len, uint32_t offset, void *buff
     size_t copied_len = 0;
     size_t sector_size = device->sector_size;
 
+    SAL_check_writeback();
+
     if (offset % sector_size){
         uint32_t sector_off = offset % sector_size;
-        size_t    copy_len  = len < sector_size 
+        size_t    copy_len  = len < sector_size - sector_off
                             ? len 
                             : sector_size - sector_off;
         copied_len          += copy_len;
@@ -63,7 +267,7 @@ void SAL_read (storage_device_t *device, size_t len, uint32_t offset, void *buff
     }
 
     while (len - copied_len >= sector_size){
-        device->read_sector(device, buff + copied_len, (offset + copied_len) / sector_size);
+        SAL_read_sector(device, buff + copied_len, (offset + copied_len) / sector_size);
         copied_len += sector_size;
     }
 
@@ -79,10 +283,12 @@ void SAL_write(storage_device_t *device, size_t len, uint32_t offset, void *buff
     size_t copied_len = 0;
     size_t sector_size = device->sector_size;
 
+    SAL_check_writeback();
+
     /* offset not on sector boundary */
     if (offset % sector_size){
         uint32_t sector_off = offset % sector_size;
-        size_t    copy_len  = len < sector_size 
+        size_t    copy_len  = len < sector_size - sector_off
                             ? len 
                             : sector_size - sector_off;
         copied_len          += copy_len;
@@ -91,7 +297,7 @@ void SAL_write(storage_device_t *device, size_t len, uint32_t offset, void *buff
     }
 
     while (len - copied_len >= sector_size){
-        device->write_sector(device, buff + copied_len, (offset + copied_len) / sector_size);
+        SAL_write_sector(device, buff + copied_len, (offset + copied_len) / sector_size);
         copied_len += sector_size;
     }
 
@@ -106,6 +312,30 @@ void SAL_write(storage_device_t *device, size_t len, uint32_t offset, void *buff
     }
 }
 
+void SAL_prefetch(storage_device_t *device, size_t len, uint32_t offset){
+    if (!len || !SAL_CACHEABLE(device)) return;
+
+    uint32_t first = offset / device->sector_size,
+             last  = (offset + len - 1) / device->sector_size;
+
+    /* dont let a big prefetch push out everything else */
+    if (last - first >= SAL_PREFETCH_MAX)
+        last = first + SAL_PREFETCH_MAX - 1;
+
+    for (uint32_t lba = first; lba <= last && lba <= device->maxlba; ++lba)
+        if (!SAL_cache_lookup(device, lba))
+            SAL_cache_get(device, lba, true);
+}
+
+/* make sure everything written so far has reached the device */
+int SAL_sync(storage_device_t *device){
+    SAL_writeback(device);
+
+    if (!device->flush) return 0;
+
+    return device->flush(device);
+}
+
 static storage_device_t *SAL_device_list;
 static uint32_t          SAL_num_devices;
 
@@ -127,5 +357,12 @@ storage_device_t *SAL_get_devices(uint32_t *out_num_devices){
     return SAL_device_list;
 }
 
-/* doesn't do anything but kept for legacy purposes */
-void SAL_init() {}
+/* sets up the block cache */
+void SAL_init() {
+    for (int i = 0; i < SAL_CACHE_BLOCKS; ++i){
+        cache_blocks[i] = (t_SALBlock){ .data = cache_data[i] };
+        SAL_lru_push(cache_blocks + i);
+    }
+
+    PIT_add_tick_handler(SAL_writeback_tick);
+}
@@ -2,74 +2,202 @@
 #include <kernel/tty.h>
 #include <kernel/kmm.h>
 #include <kernel/exe.h>
+#include <kernel/pipe.h>
+#include <kernel/ring.h>
+#include <kernel/tss.h>
+#include <kernel/io.h>
 #include <sys/sys.h>
 
+/**
+ * every syscall takes its arguments in register order,
+ *  extra arguments are ignored by the cdecl callee
+ */
+typedef uint32_t (*f_Syscall)(uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t);
+
+/* bucket 0 is everything under 2^SYS_HIST_SHIFT cycles, each next one doubles */
+#define SYS_HIST_BUCKETS 16
+#define SYS_HIST_SHIFT   8
+
+typedef struct {
+    f_Syscall   call;
+    const char *name;
+    /* errors are calls that returned -1 */
+    uint32_t    calls,
+                errors;
+    uint64_t    cycles;
+    uint32_t    hist[SYS_HIST_BUCKETS];
+} t_Syscall;
+
+#define SYSCALL(num, fn) [num] = { .call = (f_Syscall) sys_##fn, .name = #fn }
+
+static t_Syscall syscall_table[SYSCALL_MAX] = {
+    SYSCALL(SYSCALL_READ,   read),
+    SYSCALL(SYSCALL_WRITE,  write),
+    SYSCALL(SYSCALL_OPEN,   open),
+    SYSCALL(SYSCALL_CLOSE,  close),
+    SYSCALL(SYSCALL_STAT,   stat),
+    SYSCALL(SYSCALL_FSTAT,  fstat),
+    SYSCALL(SYSCALL_LSEEK,  lseek),
+    SYSCALL(SYSCALL_MMAP,   mmap),
+    SYSCALL(SYSCALL_MUNMAP, munmap),
+    SYSCALL(SYSCALL_PREAD,  pread),
+    SYSCALL(SYSCALL_PWRITE, pwrite),
+    SYSCALL(SYSCALL_READV,  readv),
+    SYSCALL(SYSCALL_WRITEV, writev),
+    SYSCALL(SYSCALL_PIPE,   pipe),
+    SYSCALL(SYSCALL_MSYNC,  msync),
+    SYSCALL(SYSCALL_EXEC,   exec),
+    SYSCALL(SYSCALL_EXIT,   exit),
+
+    SYSCALL(SYSCALL_RING_SETUP, ring_setup),
+    SYSCALL(SYSCALL_RING_ENTER, ring_enter),
+};
+
+/* latencies are only taken if there is a tsc to take them with */
+static bool has_tsc;
+
+static void SYS_account(t_Syscall *entry, uint32_t res, uint64_t cycles){
+    if (res == (uint32_t) -1) ++entry->errors;
+
+    entry->cycles += cycles;
+
+    uint32_t bucket = 0;
+
+    if (cycles >> 32)
+        bucket = SYS_HIST_BUCKETS - 1;
+    else if (cycles >> SYS_HIST_SHIFT){
+        bucket = 31 - __builtin_clz(cycles) - SYS_HIST_SHIFT + 1;
+
+        if (bucket >= SYS_HIST_BUCKETS)
+            bucket = SYS_HIST_BUCKETS - 1;
+    }
+
+    ++entry->hist[bucket];
+}
+
+uint32_t SYS_dispatch(
+    uint32_t num, 
+    uint32_t a, uint32_t b, uint32_t c, 
+    uint32_t d, uint32_t e, uint32_t f
+){
+    if (num >= SYSCALL_MAX || !syscall_table[num].call)
+        return -1;
+
+    t_Syscall *entry = syscall_table + num;
+
+    /* counted up front, exit and exec don't come back */
+    ++entry->calls;
+
+    uint64_t start = has_tsc ? cpu_tsc() : 0;
+    uint32_t res   = entry->call(a, b, c, d, e, f);
+
+    SYS_account(entry, res, has_tsc ? cpu_tsc() - start : 0);
+
+    return res;
+}
+
+/* both int 0x80 and sysenter end up here */
 void ISR_syscall_handler(registers_t *regs){
-    switch(regs->eax){
-        case SYSCALL_READ: {
-            regs->eax = sys_read(regs->ebx, (void*) regs->ecx, regs->edx);
-            break;
-        }
+    regs->eax = 
+        SYS_dispatch(
+            regs->eax,
+            regs->ebx, regs->ecx, regs->edx,
+            regs->esi, regs->edi, regs->ebp
+        );
+}
 
-        case SYSCALL_WRITE: {
-            regs->eax = sys_write(regs->ebx, (void*) regs->ecx, regs->edx);
-            break;
-        }
+/* appends the decimal n plus a separator to out */
+static char *SYS_put_num(char *out, uint64_t n, char sep){
+    char digits[20];
+    int len = 0;
 
-        case SYSCALL_OPEN: {
-            regs->eax = sys_open((void*) regs->ebx, regs->ecx);
-            break;
-        }
+    do {
+        digits[len++] = '0' + n % 10;
+        n /= 10;
+    } while (n);
 
-        case SYSCALL_CLOSE: {
-            regs->eax = sys_close(regs->ebx);
-            break;
-        }
+    while (len)
+        *out++ = digits[--len];
 
-        case SYSCALL_STAT: {
-            regs->eax = sys_stat((void*) regs->ebx, (void*) regs->ecx);
-            break;
-        }
+    *out++ = sep;
+    return out;
+}
 
-        case SYSCALL_FSTAT: {
-            regs->eax = sys_fstat(regs->ebx, (void*) regs->ecx); 
-            break;
-        }
+/* name, 3 counters and the histogram, 20 digits and a separator each */
+#define SYS_STATS_LINE (16 + 21 * (3 + SYS_HIST_BUCKETS))
 
-        case SYSCALL_LSEEK: {
-            regs->eax = sys_lseek(regs->ebx, regs->ecx, regs->edx);
-            break;
-        }
+size_t SYS_stats_read(void *buff, size_t bytes, size_t pos){
+    size_t num_entries = 0;
 
-        case SYSCALL_MMAP: {
-            regs->eax = 
-                (uint32_t) sys_mmap(
-                    (void*) regs->ebx, regs->ecx, 
-                    regs->edx, regs->esi, 
-                    regs->edi, regs->ebp
-                );
-            break;
-        }
+    for (int i = 0; i < SYSCALL_MAX; ++i)
+        if (syscall_table[i].call) ++num_entries;
 
-        case SYSCALL_MUNMAP: {
-            regs->eax = sys_munmap((void*) regs->ebx, regs->ecx);
-            break;
-        }
+    /* the table is sparse, only size the text for what is in it */
+    char *text = kmalloc(num_entries * SYS_STATS_LINE),
+         *out  = text;
 
-        case SYSCALL_EXEC: {
-            regs->eax = sys_exec((void*) regs->ebx, regs->ecx, (void*) regs->edx);
-            break;
-        }
+    if (!text) return 0;
 
-        case SYSCALL_EXIT: {
-            sys_exit(regs->ebx);
-            __builtin_unreachable();
-        }
+    for (int i = 0; i < SYSCALL_MAX; ++i){
+        t_Syscall *entry = syscall_table + i;
 
-        default: {
-            regs->eax = -1;
-        }
+        if (!entry->call) continue;
+
+        size_t name_len = strlen(entry->name);
+
+        memcpy(out, entry->name, name_len);
+        out += name_len;
+        *out++ = ' ';
+
+        out = SYS_put_num(out, entry->calls,  ' ');
+        out = SYS_put_num(out, entry->errors, ' ');
+        out = SYS_put_num(out, entry->cycles, ' ');
+
+        for (int b = 0; b < SYS_HIST_BUCKETS; ++b)
+            out = SYS_put_num(out, entry->hist[b], b == SYS_HIST_BUCKETS - 1 ? '\n' : ' ');
     }
+
+    /* the text is made again for every read, pos picks up where the last one stopped */
+    size_t len = out - text;
+    len = pos < len ? len - pos : 0;
+    if (len > bytes) len = bytes;
+
+    memcpy(buff, text + pos, len);
+    kfree(text);
+
+    return len;
+}
+
+size_t SYS_stats_reset(const void *buff, size_t bytes){
+    for (int i = 0; i < SYSCALL_MAX; ++i){
+        t_Syscall *entry = syscall_table + i;
+
+        entry->calls  = 0;
+        entry->errors = 0;
+        entry->cycles = 0;
+        memset(entry->hist, 0, sizeof entry->hist);
+    }
+
+    return bytes;
+}
+
+void SYS_init(){
+    uint32_t eax, ebx, ecx, edx;
+    cpu_id(1, &eax, &ebx, &ecx, &edx);
+
+    has_tsc = edx & CPUID_FEAT_EDX_TSC;
+
+    /* int 0x80 still works without it */
+    if (!(edx & CPUID_FEAT_EDX_SEP)) return;
+
+    /* kernel/asm/sysenter.s */
+    extern void sysenter_entry();
+
+    /* ss is cs + 8, sysexit uses cs + 16 and cs + 24 for the user segments */
+    msr_write(MSR_SYSENTER_CS,  GDT_CODE_SEGMENT);
+    /* the entry loads the stack out of the tss, it changes per process */
+    msr_write(MSR_SYSENTER_ESP, (uint32_t) &g_tss);
+    msr_write(MSR_SYSENTER_EIP, (uint32_t) sysenter_entry);
 }
 
 size_t sys_read(int fd, void *buff, size_t count){
@@ -103,6 +231,59 @@ size_t sys_lseek(int fd, ssize_t offset, int whence){
     return VFS_seek(fd, offset, whence);
 }
 
+size_t sys_pread(int fd, void *buff, size_t count, size_t offset){
+    return VFS_pread(fd, buff, count, offset);
+}
+
+size_t sys_pwrite(int fd, const void *buff, size_t count, size_t offset){
+    return VFS_pwrite(fd, buff, count, offset);
+}
+
+size_t sys_readv(int fd, const t_IOVec *iov, int iovcnt){
+    return VFS_readv(fd, iov, iovcnt);
+}
+
+size_t sys_writev(int fd, const t_IOVec *iov, int iovcnt){
+    return VFS_writev(fd, iov, iovcnt);
+}
+
+void *sys_ring_setup(){
+    /* exe.c */
+    extern t_Process *process_stack;
+
+    void *ring = RING_setup(process_stack);
+    return ring ? ring : (void*) -1;
+}
+
+int sys_ring_enter(uint32_t count){
+    extern t_Process *process_stack;
+    return RING_enter(process_stack, count);
+}
+
+int sys_pipe(int *fds){
+    t_PipeEnd *read, *write;
+
+    if (PIPE_create(&read, &write))
+        return -1;
+
+    /* a failed open closes its end, the other one is closed here */
+    fds[0] = VFS_open_file(read, &pipe_vfs_ops, VFS_FILE_READ);
+
+    if (fds[0] < 0){
+        PIPE_close(write);
+        return -1;
+    }
+
+    fds[1] = VFS_open_file(write, &pipe_vfs_ops, VFS_FILE_WRITE);
+
+    if (fds[1] < 0){
+        VFS_close(fds[0]);
+        return -1;
+    }
+
+    return 0;
+}
+
 void *sys_mmap(void *addr, size_t length, int prot, int flags, int fd, size_t offset){
     if ((uint32_t) addr % 0x1000)
         return NULL;
@@ -110,41 +291,55 @@ void *sys_mmap(void *addr, size_t length, int prot, int flags, int fd, size_t of
     /* round up to page boundary */
     uint32_t round_length = (length + 0xFFF) & ~0xFFFU;
 
+    /* fixed mappings would land on the vdso page or the stack */
+    if (flags & SYSCALL_MMAP_FLAG_FIXED && !umm_user_range(addr, round_length))
+        return (void*) -1;
+
     void *res = NULL;
     /* exe.c */
     extern t_Process *process_stack;
 
-    if (flags & SYSCALL_MMAP_FLAG_FIXED){
-        umap_pages(process_stack, addr, round_length, prot, flags);
-        res = addr;
+    if (flags & SYSCALL_MMAP_FLAG_ANONYMOUS){
+        if (flags & SYSCALL_MMAP_FLAG_FIXED){
+            umap_pages(process_stack, addr, round_length, prot, flags);
+            res = addr;
+        }
+        else
+            res = ualloc_pages(process_stack, round_length, prot, flags);
+
+        /* the frames come zeroed */
+        if (res == NULL)
+            return (void*) -1;
+
+        return res;
     }
-    else
-        res = ualloc_pages(process_stack, round_length, prot, flags);
 
-    if (res == NULL)
+    /* file mappings share frames with the page cache, so whole pages only */
+    if (offset % 0x1000)
         return (void*) -1;
 
-    if (flags & SYSCALL_MMAP_FLAG_ANONYMOUS)
-        memset(res, 0, round_length);
-    else {
-        size_t curr_off = sys_lseek(fd, 0, SYSCALL_LSEEK_CUR);
-
-        if (sys_lseek(fd, offset, SYSCALL_LSEEK_SET) != offset)
-            goto fail;
+    /* writing through a shared mapping writes the file */
+    uint8_t mode = VFS_FILE_READ;
+    if (flags & SYSCALL_MMAP_FLAG_SHARED && prot & SYSCALL_MMAP_PROT_WRITE)
+        mode |= VFS_FILE_WRITE;
 
-        size_t bytes_read = sys_read(fd, res, length);
+    /* the mapping keeps the file open, even past close(fd) */
+    t_FileDescriptor *file = VFS_hold_descriptor(fd, mode);
+    if (!file)
+        return (void*) -1;
 
-        memset(res + bytes_read, 0, length - bytes_read);
+    if (flags & SYSCALL_MMAP_FLAG_FIXED){
+        umap_file_pages(process_stack, addr, round_length, prot, flags, file, offset);
+        res = addr;
+    }
+    else {
+        res = ualloc_file_pages(process_stack, round_length, prot, flags, file, offset);
 
-        if (sys_lseek(fd, curr_off, SYSCALL_LSEEK_SET) != curr_off)
-            goto fail;
+        if (res == NULL)
+            return (void*) -1;
     }
 
     return res;
-
-fail:
-    umm_unmap_pages(process_stack, res);
-    return (void*) -1;
 }
 
 int sys_munmap(void *addr, size_t length){
@@ -161,6 +356,22 @@ int sys_munmap(void *addr, size_t length){
     return 0;
 }
 
+int sys_msync(void *addr, size_t length, int flags){
+    if ((uint32_t) addr % 0x1000)
+        return -1;
+
+    /* round up to page boundary */
+    uint32_t round_length = (length + 0xFFF) & ~0xFFFU;
+
+    /* exe.c */
+    extern t_Process *process_stack;
+
+    /* there is no background writer, so MS_ASYNC syncs too */
+    umm_sync_range(process_stack, addr, round_length);
+
+    return 0;
+}
+
 int sys_exec(const char *path, int argc, char **argv){
     stat_t file_stat;
     stat(path, &file_stat);
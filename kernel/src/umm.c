@@ -1,23 +1,24 @@
 #define __UMM_H_INTERNAL
 #include <kernel/umm.h>
 #include <kernel/exe.h>
+#include <kernel/pgc.h>
+#include <kernel/vdso.h>
 
 #define ABS(x)\
     ((x) < 0 ? (-(x)) : (x))
 
 
+/* the vdso page and the initial stack sit above the end, they have no blocks */
 static void *const user_memory_start = (void*) 0x00000000,
-            *const user_memory_end   = (void*) 0xC0000000
+            *const user_memory_end   = (void*) VDSO_VADDR
 ;
 
-void umap_pages(t_Process *process, void *vaddr, size_t len, int prot, int flags){
-    umm_block_t *new_block = kmalloc(sizeof(umm_block_t));
-    *new_block = (umm_block_t){
-        .start = vaddr,
-        .len   = len,
-        .prot  = prot,
-        .flags = flags,
-    };
+int umm_user_range(void *vaddr, size_t len){
+    return vaddr <= user_memory_end && len <= (size_t)(user_memory_end - vaddr);
+}
+
+static void umm_insert_block(t_Process *process, umm_block_t *new_block){
+    void *vaddr = new_block->start;
 
     if (process->blocks && vaddr > process->blocks->start){
         umm_block_t *block = process->blocks;
@@ -38,15 +39,131 @@ void umap_pages(t_Process *process, void *vaddr, size_t len, int prot, int flags
 
         process->blocks = new_block;
     }
+}
+
+void umap_pages(t_Process *process, void *vaddr, size_t len, int prot, int flags){
+    umm_block_t *new_block = kmalloc(sizeof(umm_block_t));
+    *new_block = (umm_block_t){
+        .start = vaddr,
+        .len   = len,
+        .prot  = prot,
+        .flags = flags,
+    };
+
+    umm_insert_block(process, new_block);
 
     for (void *i = vaddr; i < vaddr + len; i += 0x1000){
-        void *paddr = alloc_page();
+        void *paddr = alloc_zeroed_page();
         vmm_map_page(
             paddr, i, !!(prot & UMM_BLOCK_PROT_WRITE), true
         );
     }
 }
 
+static uint32_t umm_file_index(umm_block_t *block, void *page){
+    return (block->offset + (page - block->start)) / 0x1000;
+}
+
+static int umm_map_file_page(umm_block_t *block, void *page){
+    t_PGCPage *cached = PGC_map(block->file, umm_file_index(block, page));
+    if (!cached) return -1;
+
+    /* private mappings share the cached frame read-only until the first write */
+    bool write = 
+        block->flags & UMM_BLOCK_FLAG_SHARED && 
+        block->prot & UMM_BLOCK_PROT_WRITE;
+
+    vmm_map_page(cached->paddr, page, write, true);
+    vmm_new_permissions(page, write, true);
+    /* the PTE may still carry the bit from an older mapping */
+    vmm_clear_dirty(page);
+
+    return 0;
+}
+
+/* gives back the frame behind a page of block */
+static void umm_release_page(umm_block_t *block, void *page){
+    if (!block->file){
+        vfree_page(page);
+        return;
+    }
+
+    void *paddr = virt_to_phys(page);
+    if (!paddr) return;
+
+    t_PGCPage *cached = PGC_find(block->file, umm_file_index(block, page));
+
+    /* a private page that was written to has a frame of its own */
+    if (!cached || cached->paddr != paddr){
+        vfree_page(page);
+        return;
+    }
+
+    /* only pages that were actually written go back to the file */
+    if (block->flags & UMM_BLOCK_FLAG_SHARED && vmm_clear_dirty(page))
+        PGC_writeback(cached, block->file);
+
+    PGC_unmap(cached);
+    vmm_unmap_page(page);
+}
+
+void umap_file_pages(
+    t_Process *process, void *vaddr, size_t len, int prot, int flags,
+    t_FileDescriptor *file, size_t offset
+){
+    umm_block_t *new_block = kmalloc(sizeof(umm_block_t));
+    *new_block = (umm_block_t){
+        .start  = vaddr,
+        .len    = len,
+        .prot   = prot,
+        .flags  = flags,
+        .file   = file,
+        .offset = offset
+    };
+
+    /* nothing is read yet, pages come in on the first fault */
+    umm_insert_block(process, new_block);
+}
+
+void umm_sync_range(t_Process *process, void *vaddr, size_t len){
+    for (umm_block_t *block = process->blocks; block; block = block->next){
+        if (!block->file || !(block->flags & UMM_BLOCK_FLAG_SHARED))
+            continue;
+
+        void *start = block->start > vaddr ? block->start : vaddr,
+             *end   = block->start + block->len;
+
+        if (end > vaddr + len) end = vaddr + len;
+
+        for (void *page = start; page < end; page += 0x1000){
+            if (!vmm_clear_dirty(page)) continue;
+
+            t_PGCPage *cached = PGC_find(block->file, umm_file_index(block, page));
+            if (cached) PGC_writeback(cached, block->file);
+        }
+    }
+}
+
+void umm_unmap_files(t_Process *process){
+    for (umm_block_t *block = process->blocks; block; block = block->next){
+        if (!block->file) continue;
+
+        for (void *i = block->start; i < block->start + block->len; i += 0x1000)
+            umm_release_page(block, i);
+
+        VFS_put_descriptor(block->file);
+        block->file = NULL;
+    }
+}
+
+/* the ring goes with its pages, the next ring_setup maps a new one */
+static void umm_forget_ring(t_Process *process, void *start, size_t len){
+    void *ring = process->ring;
+
+    if (ring && start < ring + RING_SIZE && ring < start + len)
+        process->ring = NULL;
+}
+
 void umm_unmap_pages(t_Process *process, void *vaddr){
     for (
         umm_block_t *iter = process->blocks; 
@@ -55,50 +172,136 @@ void umm_unmap_pages(t_Process *process, void *vaddr){
     )
         if (iter->next->start == vaddr){
             umm_block_t *old_block = iter->next;
+
+            umm_forget_ring(process, vaddr, old_block->len);
+
             for (
                 void *i = vaddr; i < vaddr + old_block->len; i += 0x1000
             )
-                vmm_unmap_page(i);
+                umm_release_page(old_block, i);
+
+            if (old_block->file)
+                VFS_put_descriptor(old_block->file);
 
             iter->next = iter->next->next;
             kfree(old_block);
         }
 }
 
-void *ualloc_pages(
-    t_Process *process, size_t len, int prot, int flags
-){
+/* first fit for len bytes, -1 if the address space is full */
+static int umm_find_fit(t_Process *process, size_t len, void **out){
     umm_block_t *iter = process->blocks;
-    void *first_fit_start;
 
     if (!process->blocks){
-        first_fit_start = user_memory_start;
-        goto end;
+        *out = user_memory_start;
+        return 0;
     }
 
-    if (iter->start - user_memory_start >= len)
-        first_fit_start = user_memory_start;
-    else {
-        for (; iter->next; iter = iter->next)
-            if (iter->next->start - (iter->start + iter->len) >= len){
-                first_fit_start = iter->start + iter->len;
-                goto end;
-            }
+    if (iter->start - user_memory_start >= len){
+        *out = user_memory_start;
+        return 0;
+    }
 
-        if (user_memory_end - (iter->start + iter->len) >= len)
-            first_fit_start = iter->start + iter->len;
-        else
-            return NULL;
+    for (; iter->next; iter = iter->next)
+        if (iter->next->start - (iter->start + iter->len) >= len){
+            *out = iter->start + iter->len;
+            return 0;
+        }
+
+    if (user_memory_end - (iter->start + iter->len) >= len){
+        *out = iter->start + iter->len;
+        return 0;
     }
-end:
+
+    return -1;
+}
+
+void *ualloc_pages(
+    t_Process *process, size_t len, int prot, int flags
+){
+    void *first_fit_start;
+
+    if (umm_find_fit(process, len, &first_fit_start))
+        return NULL;
+
     umap_pages(process, first_fit_start, len, prot, flags);
     return first_fit_start;
 }
 
+void *ualloc_file_pages(
+    t_Process *process, size_t len, int prot, int flags,
+    t_FileDescriptor *file, size_t offset
+){
+    void *first_fit_start;
+
+    if (umm_find_fit(process, len, &first_fit_start)){
+        VFS_put_descriptor(file);
+        return NULL;
+    }
+
+    umap_file_pages(process, first_fit_start, len, prot, flags, file, offset);
+    return first_fit_start;
+}
+
+umm_block_t *umm_find_block(t_Process *process, void *addr){
+    for (umm_block_t *iter = process->blocks; iter; iter = iter->next)
+        if (iter->start <= addr && addr < iter->start + iter->len)
+            return iter;
+
+    return NULL;
+}
+
+/**
+ * maps the cached page in on the first access, and copies
+ *  a cached page that a private mapping wrote to into
+ *  a frame of its own
+ */
+static bool umm_file_fault(umm_block_t *block, void *page){
+    void *paddr = virt_to_phys(page);
+
+    if (!paddr){
+        if (!umm_map_file_page(block, page))
+            return true;
+
+        /**
+         * every cache frame is mapped somewhere, so there is nothing
+         *  to evict for this page and retrying would fault forever
+         */
+        printf("umm_file_fault: page cache is full, killing the process\n");
+        exit_process(-1);
+    }
+
+    if (
+        !(block->flags & UMM_BLOCK_FLAG_PRIVATE) ||
+        !(block->prot & UMM_BLOCK_PROT_WRITE)
+    )
+        return false;
+
+    t_PGCPage *cached = PGC_find(block->file, umm_file_index(block, page));
+    if (!cached || cached->paddr != paddr) return false;
+
+    vmm_map_page(alloc_page(), page, true, true);
+    page_copy(page, cached->data);
+
+    PGC_unmap(cached);
+    return true;
+}
+
 void umm_page_flt_handler(void *fault_addr){
     /* exe.c */
     extern t_Process *process_stack;
 
+    umm_block_t *block = umm_find_block(process_stack, fault_addr);
+
+    if (block){
+        void *page = (void*)((uint32_t)fault_addr & ~0xFFFU);
+
+        if (block->file && umm_file_fault(block, page))
+            return;
+
+        goto fail;
+    }
+
     if (fault_addr < process_stack->blocks->start){
         if (
             process_stack->blocks->start - user_memory_start >= 0x1000 * 2 &&
@@ -107,7 +310,7 @@ void umm_page_flt_handler(void *fault_addr){
             process_stack->blocks->start -= 0x1000;
             process_stack->blocks->len   += 0x1000;
             vmm_map_page(
-                alloc_page(),
+                alloc_zeroed_page(),
                 process_stack->blocks->start,
                 !!(process_stack->blocks->prot & UMM_BLOCK_PROT_WRITE),
                 true
@@ -135,7 +338,7 @@ void umm_page_flt_handler(void *fault_addr){
                 iter->next->start -= 0x1000;
                 iter->next->len   += 0x1000;
                 vmm_map_page(
-                    alloc_page(), iter->next->start, 
+                    alloc_zeroed_page(), iter->next->start, 
                     !!(iter->next->prot & UMM_BLOCK_PROT_WRITE), 
                     true
                 );
@@ -152,27 +355,28 @@ fail:
 }
 
 void umm_split_block(
-    umm_block_t *prev, umm_block_t *block, void *start_split, void *end_split
+    t_Process *process, umm_block_t *prev, umm_block_t *block, 
+    void *start_split, void *end_split
 ){
-    for (
-        void *addr = start_split; addr < end_split; addr += 0x1000
-    )
-        vfree_page(addr);
-
-
     umm_block_t *new_block = kmalloc(sizeof(umm_block_t));
     *new_block = (umm_block_t){
-        .start = block->start,
-        .len   = start_split - block->start,
-        .prot  = block->prot,
-        .flags = block->flags,
-        .next  = block,
+        .start  = block->start,
+        .len    = start_split - block->start,
+        .prot   = block->prot,
+        .flags  = block->flags,
+        .file   = block->file ? VFS_dup_descriptor(block->file) : NULL,
+        .offset = block->offset,
+        .next   = block,
    };
 
+    block->offset += end_split - block->start;
     block->len -= end_split - block->start;
     block->start = end_split;
 
-    prev->next = new_block;
+    if (prev)
+        prev->next = new_block;
+    else
+        process->blocks = new_block;
 }
 
 void umm_unmap_page(t_Process *process, void *page){
@@ -180,19 +384,23 @@ void umm_unmap_page(t_Process *process, void *page){
                 *prev = NULL;
 
     for (; iter; prev = iter, iter = iter->next){
+        if (page < iter->start || iter->start + iter->len <= page)
+            continue;
+
+        umm_forget_ring(process, page, 0x1000);
+        umm_release_page(iter, page);
+
         if (iter->start == page){
             iter->start += 0x1000;
+            iter->offset += 0x1000;
             iter->len -= 0x1000;
-            goto finished;
         } else
-        if (iter->start < page && page < iter->start + iter->len - 0x1000){
-            umm_split_block(prev, iter, page, page + 0x1000); 
-            goto finished;
-        } else
-        if (page == iter->start + iter->len - 0x1000){
+        if (page < iter->start + iter->len - 0x1000)
+            umm_split_block(process, prev, iter, page, page + 0x1000); 
+        else
             iter->len -= 0x1000;
-            goto finished;
-        }
+
+        goto finished;
     }
 
     return;
@@ -203,9 +411,12 @@ finished:
             prev->next = iter->next;
         else
             process->blocks = iter->next;
-    }
 
-    vfree_page(page);
+        if (iter->file)
+            VFS_put_descriptor(iter->file);
+
+        kfree(iter);
+    }
 }
 
 void umm_unmap_range(t_Process *process, void *vaddr, size_t len){
@@ -0,0 +1,63 @@
+#include <kernel/vdso.h>
+#include <kernel/pmm.h>
+#include <kernel/vmm.h>
+#include <kernel/io.h>
+#include <string.h>
+
+/* NULL until init, the timer is running long before that */
+static t_VDSOPage *page;
+static void *page_paddr;
+
+static bool     has_tsc;
+/* tsc at the start of the current second, to calibrate against */
+static uint64_t second_tsc;
+
+void VDSO_init(){
+    page_paddr = alloc_page();
+    vmm_map_page(page_paddr, (void*) VDSO_KVADDR, true, false);
+
+    memset((void*) VDSO_KVADDR, 0, PAGE_SIZE);
+
+    uint32_t eax, ebx, ecx, edx;
+    cpu_id(1, &eax, &ebx, &ecx, &edx);
+
+    has_tsc = edx & CPUID_FEAT_EDX_TSC;
+
+    if (has_tsc)
+        second_tsc = cpu_tsc();
+
+    page = (void*) VDSO_KVADDR;
+}
+
+void VDSO_update(uint64_t ticks){
+    if (!page) return;
+
+    uint32_t seq = page->seq;
+
+    __atomic_store_n(&page->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    page->data.ticks = ticks;
+    page->data.time  = time;
+
+    if (has_tsc){
+        page->data.tsc = cpu_tsc();
+
+        /* recalibrated every second, a single tick is too noisy */
+        if (!(ticks % 1000)){
+            page->data.tsc_per_tick = (page->data.tsc - second_tsc) / 1000;
+            second_tsc = page->data.tsc;
+        }
+    }
+
+    __atomic_store_n(&page->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+void VDSO_map(){
+    vmm_map_page(page_paddr, (void*) VDSO_VADDR, false, true);
+}
+
+void VDSO_unmap(){
+    /* the frame is the kernel's, so it must not be vfree'd with the process */
+    vmm_unmap_page((void*) VDSO_VADDR);
+}
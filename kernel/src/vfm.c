@@ -22,6 +22,7 @@ t_VFSOperations vfm_vfs_ops = (t_VFSOperations){
     .f_NodeName = (void*) VFM_nodename,
     .f_Stat     = (void*) VFM_fstat,
     .f_Seek     = (void*) VFM_seek,
+    .f_Extend   = (void*) VFM_extend,
 };
 
 /**
@@ -31,11 +32,112 @@ t_VFSOperations vfm_vfs_ops = (t_VFSOperations){
  *  is hereby invalidated
  */
 void VFM_free_file(t_VFMFile *file){
-    kfree(file->content);
+    t_VFMChunk *chunk = file->head;
+
+    while (chunk){
+        t_VFMChunk *next = chunk->next;
+        kfree(chunk);
+        chunk = next;
+    }
+
     kfree(file->name);
     kfree(file);
 }
 
+static t_VFMChunk *VFM_new_chunk(uint16_t at){
+    t_VFMChunk *chunk = kmalloc(sizeof *chunk);
+
+    if (chunk)
+        *chunk = (t_VFMChunk){ .start = at, .end = at };
+
+    return chunk;
+}
+
+/**
+ * returns the chunk holding byte pos and its offset in *out_base,
+ *  walking on from the last one used when going forward
+ */
+static t_VFMChunk *VFM_find_chunk(t_VFMFile *file, size_t pos, size_t *out_base){
+    t_VFMChunk *chunk = file->head;
+    size_t base = 0;
+
+    if (file->pos_chunk && pos >= file->pos_base){
+        chunk = file->pos_chunk;
+        base  = file->pos_base;
+    }
+
+    while (chunk && pos >= base + (chunk->end - chunk->start)){
+        base += chunk->end - chunk->start;
+        chunk = chunk->next;
+    }
+
+    file->pos_chunk = chunk;
+    file->pos_base  = base;
+
+    *out_base = base;
+    return chunk;
+}
+
+/* adds bytes at the end, zeroes if buff is NULL */
+static size_t VFM_append(t_VFMFile *file, size_t bytes, const void *buff){
+    size_t done = 0;
+
+    while (done < bytes){
+        if (!file->tail || file->tail->end == VFM_CHUNK_SIZE){
+            t_VFMChunk *chunk = VFM_new_chunk(0);
+            if (!chunk) break;
+
+            chunk->prev = file->tail;
+            if (file->tail) file->tail->next = chunk;
+            else            file->head = chunk;
+            file->tail = chunk;
+        }
+
+        t_VFMChunk *tail = file->tail;
+        size_t n = VFM_CHUNK_SIZE - tail->end;
+        if (n > bytes - done) n = bytes - done;
+
+        if (buff) memcpy(tail->data + tail->end, buff + done, n);
+        else      memset(tail->data + tail->end, 0, n);
+
+        tail->end  += n;
+        file->size += n;
+        done       += n;
+    }
+
+    return done;
+}
+
+/* adds bytes in front of the first byte, keeping their order */
+static size_t VFM_prepend(t_VFMFile *file, size_t bytes, const void *buff){
+    size_t left = bytes;
+
+    while (left){
+        if (!file->head || file->head->start == 0){
+            t_VFMChunk *chunk = VFM_new_chunk(VFM_CHUNK_SIZE);
+            if (!chunk) break;
+
+            chunk->next = file->head;
+            if (file->head) file->head->prev = chunk;
+            else            file->tail = chunk;
+            file->head = chunk;
+        }
+
+        t_VFMChunk *head = file->head;
+        size_t n = head->start < left ? head->start : left;
+
+        head->start -= n;
+        left        -= n;
+        memcpy(head->data + head->start, buff + left, n);
+    }
+
+    file->size += bytes - left;
+    /* every offset moved */
+    file->pos_chunk = NULL;
+
+    return bytes - left;
+}
+
 t_VFMFile *VFM_new_file(){
     if (!vfm_files){
         vfm_files = kmalloc(sizeof *vfm_files);
@@ -92,8 +194,9 @@ t_VFMHandle *VFM_create(t_VFMFile *parent, const char *name, uint8_t attribs){
 
     t_VFMFile *new = VFM_new_file();
     *new = (t_VFMFile){
-        .content = NULL,
-        .name = kmalloc(strlen(name)),
+        .head = NULL, .tail = NULL, .size = 0,
+        .pos_chunk = NULL,
+        .name = kmalloc(strlen(name) + 1),
         .pos = 0,
         .opflags = 0,
         .fileflags = attribs, .modified = vfm_start_chrono
@@ -136,35 +239,64 @@ void VFM_close(t_VFMFile *file){
 }
 
 size_t VFM_read(t_VFMFile *file, size_t bytes, void *buff){
-    size_t fsize = ksize(file->content),
-           csize = file->pos + bytes > fsize
-                   ? fsize - file->pos : bytes;
+    if (file->pos >= file->size) return 0;
+    if (bytes > file->size - file->pos) bytes = file->size - file->pos;
+
+    size_t base, done = 0;
+    t_VFMChunk *chunk = VFM_find_chunk(file, file->pos, &base);
+
+    /* gather across chunks */
+    for (; chunk && done < bytes; base += chunk->end - chunk->start, chunk = chunk->next){
+        size_t off = file->pos + done - base,
+               n   = chunk->end - chunk->start - off;
+
+        if (n > bytes - done) n = bytes - done;
 
-    memcpy(buff, file->content + file->pos, csize);
-    file->pos += csize;
-    return csize;
+        memcpy(buff + done, chunk->data + chunk->start + off, n);
+        done += n;
+    }
+
+    file->pos += done;
+    return done;
 }
 
 size_t VFM_write(t_VFMFile *file, size_t bytes, const void *buff){
-    size_t fsize = ksize(file->content);
-    if (file->pos + bytes > fsize)
-        file->content = kexpand(file->content, bytes);
+    size_t done = 0;
+
+    /* overwrite whatever is already there */
+    if (file->pos < file->size){
+        size_t base;
+        t_VFMChunk *chunk = VFM_find_chunk(file, file->pos, &base);
 
-    memcpy(file->content + file->pos, buff, bytes);
-    file->pos += bytes;
+        size_t over = file->size - file->pos < bytes ? file->size - file->pos : bytes;
+
+        for (; chunk && done < over; base += chunk->end - chunk->start, chunk = chunk->next){
+            size_t off = file->pos + done - base,
+                   n   = chunk->end - chunk->start - off;
+
+            if (n > over - done) n = over - done;
+
+            memcpy(chunk->data + chunk->start + off, buff + done, n);
+            done += n;
+        }
+    }
+
+    /* a hole left by seeking past the end reads as zeroes */
+    if (file->pos > file->size)
+        VFM_append(file, file->pos - file->size, NULL);
+
+    done += VFM_append(file, bytes - done, buff + done);
+
+    file->pos += done;
     VFS_curr_chrono(&file->modified);
-    return bytes;
+    return done;
 }
 
 size_t VFM_writeback(t_VFMFile *file, size_t bytes, const void *buff){
-    size_t fsize = ksize(file->content);
-    if (file->pos + bytes > fsize)
-        file->content = kexpand(file->content, bytes);
-    memcpy(file->content + bytes, file->content, bytes);
-    memcpy(file->content, buff, bytes);
+    size_t done = VFM_prepend(file, bytes, buff);
 
     VFS_curr_chrono(&file->modified);
-    return bytes;
+    return done;
 }
 
 t_VFMFile *VFM_ReadDir(t_VFMFile *dir, size_t n){
@@ -191,11 +323,23 @@ void VFM_fstat(t_VFMHandle *file, t_FileStat *out){
     *out = (t_FileStat){
         .created = vfm_start_chrono,
         .modified = file->modified,
-        .size = ksize(file->content),
+        .size = file->size,
         .flags = file->fileflags
     };
 }
 
-void VFM_seek(t_VFMFile *file, size_t position){
-    file->pos = position;
+size_t VFM_extend(t_VFMFile *file, size_t size){
+    if (size <= file->size) return file->size;
+
+    VFM_append(file, size - file->size, NULL);
+    VFS_curr_chrono(&file->modified);
+
+    return file->size;
+}
+
+size_t VFM_seek(t_VFMFile *file, size_t position){
+    if (position != -1)
+        file->pos = position;
+
+    return file->pos;
 }
@@ -2,7 +2,10 @@
 #include <kernel/rtc.h>
 #include <kernel/vfm.h>
 #include <kernel/dev.h>
+#include <kernel/pgc.h>
+#include <kernel/exe.h>
 #include <string.h>
+#include <stdlib.h>
 #include <stdio.h>
 
 #define _VFS_H_INTERNAL
@@ -19,6 +22,9 @@ static size_t num_drivers;
 static t_MountPoint *mounts;
 static size_t num_mounts;
 static t_VFSNode vfs_root;
+
+static int VFS_add_descriptor(t_FileDescriptor *file);
+
 void VFS_register_fs(t_VFSOperations *driver){
     vfsops = kexpand(vfsops, sizeof *driver);
     vfsops[num_drivers++] = *driver;
@@ -36,24 +42,33 @@ t_FSContext *VFS_try_mount(storage_device_t *dev, t_VFSOperations **out){
 
 void VFS_mount_root(t_FSContext *fs, t_VFSOperations *fsops){
     vfs_root = (t_VFSNode){
-        .parent = NULL, .children = NULL, .next = NULL,
+        .parent = NULL,
+        .pinned = true,
         .driver = fsops,
         .handle = fsops->f_Root(fs),
     };
 }
 
+/* mounts the root of another driver as a child of the root directory */
+static t_VFSNode *VFS_mount_at_root(t_FSNode root, t_VFSOperations *ops){
+    t_VFSNode *vnode = VFS_make_vnode(&vfs_root, ops->f_NodeName(root), root);
+
+    vnode->driver = ops;
+    vnode->pinned = true;
+
+    /* drop a negative entry for the name, if there is one */
+    VFS_invalidate(&vfs_root, vnode->name);
+    VFS_insert_vnode(&vfs_root, vnode);
+
+    return vnode;
+}
+
 void VFS_init_virt(){
-    t_FSNode virt_root = VFM_root();
-    t_VFSNode *virt_root_vnode = VFS_make_vnode(&vfs_root, virt_root);
-    virt_root_vnode->driver = &vfm_vfs_ops;
-    VFS_insert_vnode(&vfs_root, virt_root_vnode);
+    VFS_mount_at_root(VFM_root(), &vfm_vfs_ops);
 }
 
 void VFS_init_dev(){
-    t_FSNode dev_root = DEV_root();
-    t_VFSNode *dev_root_vnode = VFS_make_vnode(&vfs_root, dev_root);
-    dev_root_vnode->driver = &dev_vfs_ops;
-    VFS_insert_vnode(&vfs_root, dev_root_vnode);
+    t_VFSNode *dev_root_vnode = VFS_mount_at_root(DEV_root(), &dev_vfs_ops);
 
     t_VFSNode *vfs_stdin = VFS_lookup(dev_root_vnode, "STDIN"),
              *vfs_stdout = VFS_lookup(dev_root_vnode, "STDOUT")
@@ -64,15 +79,24 @@ void VFS_init_dev(){
     ;
 
     *fd0 = (t_FileDescriptor){
-        .descriptor = vfs_stdin->handle,
-        .driver     = vfs_stdin->driver
+        .descriptor = vfs_stdin->driver->f_Open(vfs_stdin->handle, VFS_FILE_READ),
+        .driver     = vfs_stdin->driver,
+        .vnode      = vfs_stdin,
+        .mode       = VFS_FILE_READ,
+        .refs       = 1
     };
 
     *fd1 = (t_FileDescriptor){
-        .descriptor = vfs_stdout->handle,
-        .driver     = vfs_stdout->driver
+        .descriptor = vfs_stdout->driver->f_Open(vfs_stdout->handle, VFS_FILE_WRITE),
+        .driver     = vfs_stdout->driver,
+        .vnode      = vfs_stdout,
+        .mode       = VFS_FILE_WRITE,
+        .refs       = 1
     };
 
+    ++vfs_stdin->refs;
+    ++vfs_stdout->refs;
+
     VFS_add_descriptor(fd0);
     VFS_add_descriptor(fd1);
 }
@@ -90,10 +114,10 @@ void VFS_init_rootfs(){
         else
             printf("Fuck you. Installing...\n");
 
-        /* marker file for LakeOS */
-        vfs_root.driver->f_Create(vfs_root.handle, "LAKEOS", FILE_ATTRIB_READ_ONLY);
-        vfs_root.driver->f_Create(vfs_root.handle, "USER", FILE_ATTRIB_DIRECTORY);
-        vfs_root.driver->f_Create(vfs_root.handle, "BIN",  FILE_ATTRIB_DIRECTORY);
+        /* marker file for LakeOS, the lookup above cached it as missing */
+        VFS_make_file(&vfs_root, "LAKEOS", FILE_ATTRIB_READ_ONLY);
+        VFS_make_file(&vfs_root, "USER", FILE_ATTRIB_DIRECTORY);
+        VFS_make_file(&vfs_root, "BIN",  FILE_ATTRIB_DIRECTORY);
     }
 
     VFS_init_virt();
@@ -146,112 +170,366 @@ void VFS_curr_chrono(t_FileChrono *out){
     };
 }
 
-void VFS_insert_vnode(t_VFSNode *parent, t_VFSNode *child){
-    t_VFSNode *iter = parent->children;
+/**
+ * DENTRY CACHE
+ */
 
-    if (!iter){
-        parent->children = child;
-        return;
+static t_VFSNode *dentry_buckets[VFS_DENTRY_BUCKETS];
+/* head is the most recently used vnode */
+static t_VFSNode *dentry_lru_head, *dentry_lru_tail;
+static uint32_t   num_dentries;
+
+static uint32_t VFS_dentry_hash(t_VFSNode *parent, const char *name, size_t len){
+    uint32_t hash = (uint32_t)parent >> 4;
+
+    for (size_t i = 0; i < len; ++i)
+        hash = hash * 31 + name[i];
+
+    return hash % VFS_DENTRY_BUCKETS;
+}
+
+static void VFS_lru_unlink(t_VFSNode *node){
+    if (node->lru_prev) node->lru_prev->lru_next = node->lru_next;
+    else                dentry_lru_head = node->lru_next;
+
+    if (node->lru_next) node->lru_next->lru_prev = node->lru_prev;
+    else                dentry_lru_tail = node->lru_prev;
+}
+
+static void VFS_lru_push(t_VFSNode *node){
+    node->lru_prev = NULL;
+    node->lru_next = dentry_lru_head;
+
+    if (dentry_lru_head) dentry_lru_head->lru_prev = node;
+    else                 dentry_lru_tail = node;
+
+    dentry_lru_head = node;
+}
+
+/* name doesn't need to be null terminated */
+static t_VFSNode *VFS_dentry_find(t_VFSNode *parent, const char *name, size_t len){
+    t_VFSNode *node = dentry_buckets[VFS_dentry_hash(parent, name, len)];
+
+    for (; node; node = node->hash_next)
+        if (node->parent == parent && 
+            !memcmp(node->name, name, len) && !node->name[len])
+            break;
+
+    return node;
+}
+
+/* lookups stop finding the vnode, it stays on the lru until it is freed */
+static void VFS_dentry_unhash(t_VFSNode *node){
+    t_VFSNode **link = &dentry_buckets[VFS_dentry_hash(node->parent, node->name, strlen(node->name))];
+
+    while (*link && *link != node)
+        link = &(*link)->hash_next;
+
+    if (*link) *link = node->hash_next;
+
+    node->hash_next = NULL;
+}
+
+/* takes the vnode out of the cache and frees it */
+static void VFS_dentry_free(t_VFSNode *node){
+    VFS_dentry_unhash(node);
+    VFS_lru_unlink(node);
+    --node->parent->num_children;
+    --num_dentries;
+
+    PGC_invalidate(node);
+
+    if (node->handle && node->driver->f_Release)
+        node->driver->f_Release(node->handle);
+
+    kfree(node);
+}
+
+/* evicts least recently used leaves until the cache fits again */
+static void VFS_dentry_shrink(t_VFSNode *keep){
+    t_VFSNode *node = dentry_lru_tail;
+
+    while (num_dentries > VFS_DENTRY_MAX && node){
+        t_VFSNode *prev = node->lru_prev;
+
+        if (node != keep && !node->pinned && !node->refs && !node->num_children)
+            VFS_dentry_free(node);
+
+        node = prev;
     }
+}
 
-    while (iter->next)
-        iter = iter->next;
+/**
+ * drops the cached entry for name in parent, used when the
+ *  fs changes underneath (create, remove)
+ */
+void VFS_invalidate(t_VFSNode *parent, const char *name){
+    size_t len = strlen(name);
+    if (len >= VFS_NAME_MAX) return;
+
+    t_VFSNode *node = VFS_dentry_find(parent, name, len);
+
+    if (!node || node->pinned) return;
+
+    if (!node->num_children && !node->refs)
+        VFS_dentry_free(node);
+    /**
+     * a removed directory with cached children can't be freed
+     *  yet, so it just stops answering for the name, the lru
+     *  frees it once its children are gone
+     */
+    else if (!node->handle)
+        VFS_dentry_unhash(node);
+}
 
-    iter->next = child;
+void VFS_insert_vnode(t_VFSNode *parent, t_VFSNode *child){
+    uint32_t bucket = VFS_dentry_hash(parent, child->name, strlen(child->name));
+
+    child->parent    = parent;
+    child->hash_next = dentry_buckets[bucket];
+    dentry_buckets[bucket] = child;
+
+    VFS_lru_push(child);
+    ++parent->num_children;
+    ++num_dentries;
+
+    VFS_dentry_shrink(child);
 }
 
-t_VFSNode *VFS_make_vnode(t_VFSNode *parent, t_FSNode *handle){
+t_VFSNode *VFS_make_vnode(t_VFSNode *parent, const char *name, t_FSNode *handle){
     t_VFSNode *node = kmalloc(sizeof(t_VFSNode));
+    if (!node) return NULL;
+
     *node = (t_VFSNode){
         .parent = parent,
-        .children = NULL,
-        .next = NULL,
         .handle = handle,
         .driver = parent->driver
     };
 
+    size_t len = strlen(name);
+    if (len >= VFS_NAME_MAX) len = VFS_NAME_MAX - 1;
+
+    memcpy(node->name, name, len);
+    node->name[len] = '\0';
+
     return node;
 }
 
-t_VFSNode *VFS_walk_path(const char *_path){
-    char *path = strdup(_path);
-    char *name = strtok(path, "/");
-    t_VFSNode *iter = &vfs_root;
+void VFS_path_iter(t_PathIter *iter, const char *path, size_t len){
+    *iter = (t_PathIter){
+        .pos  = path,
+        .end  = path + len,
+        .name = path,
+        .len  = 0
+    };
+}
 
-    for (; name; name = strtok(NULL, "/")){
-        iter = VFS_lookup(iter, name);
-        if (!iter) return iter;
-    }
+bool VFS_path_next(t_PathIter *iter){
+    const char *pos = iter->pos;
+
+    while (pos < iter->end && *pos == '/')
+        ++pos;
+
+    if (pos >= iter->end || !*pos)
+        return false;
+
+    iter->name = pos;
+
+    while (pos < iter->end && *pos && *pos != '/')
+        ++pos;
+
+    iter->len = pos - iter->name;
+    iter->pos = pos;
+
+    return true;
+}
+
+static t_VFSNode *VFS_lookup_n(t_VFSNode *parent, const char *name, size_t len);
+
+static t_VFSNode *VFS_walk_path_n(const char *path, size_t len){
+    t_PathIter iter;
+    t_VFSNode *node = &vfs_root;
 
-    kfree(path);
+    VFS_path_iter(&iter, path, len);
 
-    return iter;
+    while (node && VFS_path_next(&iter))
+        node = VFS_lookup_n(node, iter.name, iter.len);
+
+    return node;
 }
 
-t_VFSNode *VFS_get_dir_and_fname(const char *_path, char **out_fname){
-    char *path = strdup(_path);
+t_VFSNode *VFS_walk_path(const char *path){
+    return VFS_walk_path_n(path, strlen(path));
+}
 
+t_VFSNode *VFS_get_dir_and_fname(const char *path, char **out_fname){
     int i = strlen(path) - 1;
 
     for (; i >= 0; --i)
-        if (path[i] == '/'){
-            path[i] = '\0';
+        if (path[i] == '/')
             break;
-        }
 
-    *out_fname = (char*)_path + i + 1;
+    *out_fname = (char*)path + i + 1;
 
-    t_VFSNode *dir = VFS_walk_path(path);
-
-    kfree(path);
-
-    return dir;
+    return VFS_walk_path_n(path, i < 0 ? 0 : i);
 }
 
 size_t VFS_make_file
     (t_VFSNode *parent, const char *name, uint8_t attribs)
 {
+    /* a negative entry for the name would be stale now */
+    VFS_invalidate(parent, name);
+
     parent->driver->f_Create(parent->handle, name, attribs);
     return 0;
 }
 
+static t_VFSNode *VFS_lookup_n(t_VFSNode *parent, const char *name, size_t len){
+    if (len >= VFS_NAME_MAX) return NULL;
+
+    t_VFSNode *vnode = VFS_dentry_find(parent, name, len);
+
+    if (vnode){
+        VFS_lru_unlink(vnode);
+        VFS_lru_push(vnode);
+
+        return vnode->handle ? vnode : NULL;
+    }
+
+    /* drivers want null terminated names, only misses pay for the copy */
+    char buff[VFS_NAME_MAX];
+    memcpy(buff, name, len);
+    buff[len] = '\0';
+
+    /* cache misses too, so repeated lookups of missing names are cheap */
+    t_FSNode *node = parent->driver->f_Lookup(parent->handle, buff);
+
+    vnode = VFS_make_vnode(parent, buff, node);
+    if (!vnode) return NULL;
+
+    VFS_insert_vnode(parent, vnode);
+
+    return node ? vnode : NULL;
+}
+
 t_VFSNode *VFS_lookup(t_VFSNode *parent, const char *name){
-    for (t_VFSNode *node = parent->children; node; node = node->next){
-        const char *nodename = node->driver->f_NodeName(node->handle);
-        if (!strcmp(nodename, name)) return node;
+    return VFS_lookup_n(parent, name, strlen(name));
+}
+
+/* tables start at one bitmap word and double from there */
+#define VFS_FD_MIN 32
+
+/* descriptors opened before the first process (stdin/stdout) */
+static t_FDTable kernel_fds;
+
+t_FDTable *VFS_fd_table(){
+    extern t_Process *process_stack;
+    return process_stack ? &process_stack->fds : &kernel_fds;
+}
+
+static bool VFS_fd_table_grow(t_FDTable *table){
+    size_t size = table->size ? table->size * 2 : VFS_FD_MIN;
+
+    /* both or neither, the table is left as it was if either fails */
+    t_FileDescriptor **files = kmalloc(size * sizeof *files);
+    uint32_t *used = kmalloc(size / 32 * sizeof *used);
+
+    if (!files || !used){
+        if (files) kfree(files);
+        if (used)  kfree(used);
+        return false;
     }
 
-    t_FSNode *node = parent->driver->f_Lookup(parent->handle, name);
-    if (node){
-        t_VFSNode *vnode = VFS_make_vnode(parent, node);
-        VFS_insert_vnode(parent, vnode);
-        return vnode;
+    if (table->size){
+        memcpy(files, table->files, table->size * sizeof *files);
+        memcpy(used, table->used, table->size / 32 * sizeof *used);
+
+        kfree(table->files);
+        kfree(table->used);
     }
 
-    return NULL;
+    memset(files + table->size, 0, (size - table->size) * sizeof *files);
+    memset(used + table->size / 32, 0, (size - table->size) / 32 * sizeof *used);
+
+    table->files = files;
+    table->used  = used;
+    table->size  = size;
+    return true;
 }
 
-static t_FSFile *descriptor_list;
-static size_t descriptor_list_size;
+/* the lowest free fd, one bsf per 32 descriptors */
+static int VFS_add_descriptor(t_FileDescriptor *file){
+    t_FDTable *table = VFS_fd_table();
+    size_t word = 0;
 
-int VFS_add_descriptor(t_FSFile file){
-    for (size_t i = 0; i < descriptor_list_size; ++i){
-        if (descriptor_list[i] == NULL){
-            descriptor_list[i] = file;
-            return i;
-        }
+    while (word < table->size / 32 && table->used[word] == 0xFFFFFFFF)
+        ++word;
+
+    if (word == table->size / 32 && !VFS_fd_table_grow(table))
+        return -1;
+
+    int fd = word * 32 + __builtin_ctz(~table->used[word]);
+
+    table->used[word] |= 1u << (fd % 32);
+    table->files[fd]   = file;
+
+    return fd;
+}
+
+static t_FileDescriptor *VFS_get_descriptor(int fd){
+    t_FDTable *table = VFS_fd_table();
+
+    if (fd < 0 || (size_t)fd >= table->size) return NULL;
+
+    return table->files[fd];
+}
+
+static t_FileDescriptor *VFS_rem_descriptor(int fd){
+    t_FDTable *table = VFS_fd_table();
+    t_FileDescriptor *file = VFS_get_descriptor(fd);
+
+    if (file){
+        table->files[fd] = NULL;
+        table->used[fd / 32] &= ~(1u << (fd % 32));
     }
 
-    /* if the list needs to be expanded */
+    return file;
+}
+
+void VFS_fd_table_copy(t_FDTable *table, const t_FDTable *parent){
+    *table = (t_FDTable){0};
+
+    if (!parent->size) return;
+
+    table->files = kmalloc(parent->size * sizeof *table->files);
+    table->used  = kmalloc(parent->size / 32 * sizeof *table->used);
 
-    descriptor_list = kexpand(descriptor_list, sizeof file);
-    descriptor_list[descriptor_list_size] = file;
-    return descriptor_list_size++;
+    if (!table->files || !table->used){
+        if (table->files) kfree(table->files);
+        if (table->used)  kfree(table->used);
+
+        *table = (t_FDTable){0};
+        return;
+    }
+
+    memcpy(table->files, parent->files, parent->size * sizeof *table->files);
+    memcpy(table->used, parent->used, parent->size / 32 * sizeof *table->used);
+    table->size = parent->size;
+
+    for (size_t i = 0; i < table->size; ++i)
+        if (table->files[i])
+            VFS_dup_descriptor(table->files[i]);
 }
 
-void VFS_rem_descriptor(int fd){
-    /* lazily deallocate */
-    descriptor_list[fd] = NULL;
+void VFS_fd_table_free(t_FDTable *table){
+    for (size_t i = 0; i < table->size; ++i)
+        if (table->files[i])
+            VFS_put_descriptor(table->files[i]);
+
+    if (table->files) kfree(table->files);
+    if (table->used)  kfree(table->used);
+
+    *table = (t_FDTable){0};
 }
 
 /**
@@ -260,37 +538,230 @@ void VFS_rem_descriptor(int fd){
 
 int VFS_open(const char *path, uint8_t mode){
     t_VFSNode *vnode = VFS_walk_path(path);
+    if (!vnode) return -1;
 
     t_FSFile file = vnode->driver->f_Open(vnode->handle, mode);
+    if (!file) return -1;
 
     t_FileDescriptor *res = kmalloc(sizeof(t_FileDescriptor));
+    if (!res){
+        vnode->driver->f_Close(file);
+        return -1;
+    }
 
     *res = (t_FileDescriptor){
         .descriptor = file,
-        .driver     = vnode->driver
+        .driver     = vnode->driver,
+        .vnode      = vnode,
+        .mode       = mode,
+        .refs       = 1
     };
 
-    return VFS_add_descriptor(res);
+    /* keeps the vnode (and its cached pages) around while open */
+    ++vnode->refs;
+
+    int fd = VFS_add_descriptor(res);
+    if (fd < 0) VFS_put_descriptor(res);
+
+    return fd;
 }
 
-void VFS_close(int fd){
-    t_FileDescriptor *descriptor = descriptor_list[fd];
+int VFS_open_file(t_FSFile file, t_VFSOperations *ops, uint8_t mode){
+    t_FileDescriptor *res = kmalloc(sizeof(t_FileDescriptor));
+
+    if (!res){
+        ops->f_Close(file);
+        return -1;
+    }
+
+    *res = (t_FileDescriptor){
+        .descriptor = file,
+        .driver     = ops,
+        .vnode      = NULL,
+        .mode       = mode,
+        .refs       = 1
+    };
+
+    int fd = VFS_add_descriptor(res);
+    if (fd < 0) VFS_put_descriptor(res);
+
+    return fd;
+}
+
+t_FileDescriptor *VFS_hold_descriptor(int fd, uint8_t mode){
+    t_FileDescriptor *descriptor = VFS_get_descriptor(fd);
+
+    if (!descriptor || !descriptor->vnode || (descriptor->mode & mode) != mode)
+        return NULL;
+
+    ++descriptor->refs;
+    return descriptor;
+}
+
+t_FileDescriptor *VFS_dup_descriptor(t_FileDescriptor *descriptor){
+    ++descriptor->refs;
+    return descriptor;
+}
+
+void VFS_put_descriptor(t_FileDescriptor *descriptor){
+    if (--descriptor->refs) return;
+
     descriptor->driver->f_Close(descriptor->descriptor);
+
+    if (descriptor->vnode)
+        --descriptor->vnode->refs;
+
     kfree(descriptor);
 }
 
+void VFS_close(int fd){
+    t_FileDescriptor *descriptor = VFS_rem_descriptor(fd);
+
+    if (descriptor)
+        VFS_put_descriptor(descriptor);
+}
+
+/* devices can't seek, those go straight to the driver */
+static bool VFS_cached(t_FileDescriptor *descriptor){
+    return descriptor->driver->f_Seek != NULL;
+}
+
 size_t VFS_write(int fd, void *data, size_t len){
-    t_FileDescriptor *descriptor = descriptor_list[fd];
+    t_FileDescriptor *descriptor = VFS_get_descriptor(fd);
+    if (!descriptor) return -1;
 
-    return
-        descriptor->driver->f_Write(descriptor->descriptor, len, data);
+    if (!VFS_cached(descriptor))
+        return
+            descriptor->driver->f_Write(descriptor->descriptor, len, data);
+
+    /* write through, then bring any cached pages up to date */
+    size_t pos = descriptor->driver->f_Seek(descriptor->descriptor, -1),
+           res = descriptor->driver->f_Write(descriptor->descriptor, len, data);
+
+    PGC_update(descriptor->vnode, pos, res, data);
+
+    return res;
 }
 
 size_t VFS_read(int fd, void *data, size_t len){
-    t_FileDescriptor *descriptor = descriptor_list[fd];
+    t_FileDescriptor *descriptor = VFS_get_descriptor(fd);
+    if (!descriptor) return -1;
 
-    return
-        descriptor->driver->f_Read(descriptor->descriptor, len, data);
+    if (!VFS_cached(descriptor))
+        return
+            descriptor->driver->f_Read(descriptor->descriptor, len, data);
+
+    if (!(descriptor->mode & VFS_FILE_READ)) return 0;
+
+    size_t pos = descriptor->driver->f_Seek(descriptor->descriptor, -1),
+           res = PGC_read(descriptor, pos, len, data);
+
+    descriptor->driver->f_Seek(descriptor->descriptor, pos + res);
+
+    return res;
+}
+
+size_t VFS_pwrite(int fd, const void *data, size_t len, size_t offset){
+    t_FileDescriptor *descriptor = VFS_get_descriptor(fd);
+    if (!descriptor) return -1;
+
+    if (!VFS_cached(descriptor)) return -1;
+
+    t_VFSOperations *ops = descriptor->driver;
+    size_t pos = ops->f_Seek(descriptor->descriptor, -1);
+
+    ops->f_Seek(descriptor->descriptor, offset);
+    size_t res = ops->f_Write(descriptor->descriptor, len, data);
+    ops->f_Seek(descriptor->descriptor, pos);
+
+    PGC_update(descriptor->vnode, offset, res, data);
+
+    return res;
+}
+
+size_t VFS_pread(int fd, void *data, size_t len, size_t offset){
+    t_FileDescriptor *descriptor = VFS_get_descriptor(fd);
+    if (!descriptor) return -1;
+
+    if (!VFS_cached(descriptor)) return -1;
+    if (!(descriptor->mode & VFS_FILE_READ)) return 0;
+
+    /* the cache reads at any offset, the file position stays put */
+    return PGC_read(descriptor, offset, len, data);
+}
+
+size_t VFS_writev(int fd, const t_IOVec *iov, int iovcnt){
+    t_FileDescriptor *descriptor = VFS_get_descriptor(fd);
+    if (!descriptor) return -1;
+    t_VFSOperations *ops = descriptor->driver;
+    size_t res = 0;
+
+    if (!VFS_cached(descriptor)){
+        if (ops->f_WriteV)
+            return ops->f_WriteV(descriptor->descriptor, iov, iovcnt);
+
+        for (int i = 0; i < iovcnt; ++i)
+            res += ops->f_Write(descriptor->descriptor, iov[i].len, iov[i].base);
+
+        return res;
+    }
+
+    size_t pos = ops->f_Seek(descriptor->descriptor, -1);
+
+    if (ops->f_WriteV)
+        res = ops->f_WriteV(descriptor->descriptor, iov, iovcnt);
+    else
+        for (int i = 0; i < iovcnt; ++i){
+            size_t n = ops->f_Write(descriptor->descriptor, iov[i].len, iov[i].base);
+            res += n;
+
+            if (n < iov[i].len) break;
+        }
+
+    /* bring the cached pages up to date buffer by buffer */
+    size_t done = 0;
+
+    for (int i = 0; i < iovcnt && done < res; ++i){
+        size_t n = iov[i].len < res - done ? iov[i].len : res - done;
+
+        PGC_update(descriptor->vnode, pos + done, n, iov[i].base);
+        done += n;
+    }
+
+    return res;
+}
+
+size_t VFS_readv(int fd, const t_IOVec *iov, int iovcnt){
+    t_FileDescriptor *descriptor = VFS_get_descriptor(fd);
+    if (!descriptor) return -1;
+    t_VFSOperations *ops = descriptor->driver;
+    size_t res = 0;
+
+    if (!VFS_cached(descriptor)){
+        if (ops->f_ReadV)
+            return ops->f_ReadV(descriptor->descriptor, iov, iovcnt);
+
+        for (int i = 0; i < iovcnt; ++i)
+            res += ops->f_Read(descriptor->descriptor, iov[i].len, iov[i].base);
+
+        return res;
+    }
+
+    if (!(descriptor->mode & VFS_FILE_READ)) return 0;
+
+    /* cached files are served from the page cache, no driver hook needed */
+    size_t pos = ops->f_Seek(descriptor->descriptor, -1);
+
+    for (int i = 0; i < iovcnt; ++i){
+        size_t n = PGC_read(descriptor, pos + res, iov[i].len, iov[i].base);
+        res += n;
+
+        if (n < iov[i].len) break;
+    }
+
+    ops->f_Seek(descriptor->descriptor, pos + res);
+
+    return res;
 }
 
 void VFS_create(const char *path, uint8_t attributes){
@@ -303,16 +774,20 @@ void VFS_create(const char *path, uint8_t attributes){
 void VFS_remove(const char *path){
     t_VFSNode *vnode = VFS_walk_path(path);
 
-    vnode->driver->f_Remove(vnode->handle);
-
-    t_VFSNode *iter = vnode->parent->children;
+    /**
+     * the driver frees the clusters right away, an open descriptor
+     *  or a mapping would go on writing to them, so open files stay
+     */
+    if (!vnode || vnode->pinned || vnode->refs) return;
 
-    while (iter->next != vnode)
-        iter = iter->next;
+    PGC_invalidate(vnode);
+    vnode->driver->f_Remove(vnode->handle);
 
-    iter->next = iter->next->next;
+    /* the node stays cached as a negative entry */
+    if (vnode->driver->f_Release)
+        vnode->driver->f_Release(vnode->handle);
 
-    kfree(vnode->handle);
+    vnode->handle = NULL;
 }
 
 void VFS_stat(const char *path, const t_FileStat *stat){
@@ -321,16 +796,22 @@ void VFS_stat(const char *path, const t_FileStat *stat){
 }
 
 void VFS_fstat(int fd, const t_FileStat *stat){
-    t_FileDescriptor *descriptor = descriptor_list[fd];
+    t_FileDescriptor *descriptor = VFS_get_descriptor(fd);
+    if (!descriptor) return;
 
+    /* f_Stat takes a node, not an open file, unless there is no node */
     return
-        descriptor->driver->f_Stat(descriptor->descriptor, stat);
+        descriptor->driver->f_Stat(
+            descriptor->vnode ? descriptor->vnode->handle : descriptor->descriptor, 
+            stat
+        );
 }
 
 size_t VFS_seek(int fd, ssize_t offset, int whence){
-    t_FileDescriptor *descriptor = descriptor_list[fd];
+    t_FileDescriptor *descriptor = VFS_get_descriptor(fd);
 
-    if (!descriptor)
+    /* pipes and devices can't seek */
+    if (!descriptor || !descriptor->driver->f_Seek)
         return -1;
 
     t_FileStat stat;
@@ -361,10 +842,21 @@ size_t VFS_seek(int fd, ssize_t offset, int whence){
     if (new_pos < 0)
         return -1;
 
-    /* expand the file with null bytes if necessary */
-    if (new_pos > stat.size){
+    /* expand the file with null bytes if necessary, read-only descriptors just move past the end */
+    bool grow = new_pos > stat.size && descriptor->mode & VFS_FILE_WRITE;
+
+    if (grow && descriptor->driver->f_Extend){
+        if (descriptor->driver->f_Extend(descriptor->descriptor, new_pos) < new_pos)
+            return -1;
+
+        PGC_extend(descriptor->vnode, new_pos);
+    }
+    else if (grow){
         static uint8_t zero_buff[0xFF];
 
+        /* writes land at the file position */
+        descriptor->driver->f_Seek(descriptor->descriptor, stat.size);
+
         while (new_pos - stat.size >= 0xFF){
             VFS_write(fd, &zero_buff, 0xFF);
             stat.size += 0xFF;
@@ -1,4 +1,6 @@
+#define _STRING_H_INTERNAL
 #include <kernel/isr.h>
+#include <kernel/pit.h>
 #include <kernel/pmm.h>
 #include <kernel/vmm.h>
 #include <kernel/umm.h>
@@ -84,11 +86,9 @@ void *vmm_map_page(void *paddr, void *vaddr, bool write, bool ring3) {
     /* page table not present, allocate */
     if (!ENTRY_GET_ATTRIBUTE(*pdir_entry, PAGE_STRUCT_ENTRY_PRESENT)) {
         /* map the page table so it can be used */
-        ENTRY_SET_FRAME(*map_ptable_entry, alloc_page());
+        ENTRY_SET_FRAME(*map_ptable_entry, alloc_zeroed_page());
         flush_tlb_entry(0xC03FF000);
 
-        memset(ptable, 0, ENTRIES_PER_STRUCT * sizeof(pt_entry_t));
-
         /* set new page table as writeable and present */
         ENTRY_ADD_ATTRIBUTE(*pdir_entry, PAGE_STRUCT_ENTRY_PRESENT);
         ENTRY_ADD_ATTRIBUTE(*pdir_entry, PAGE_STRUCT_ENTRY_WRITEABLE);
@@ -148,6 +148,143 @@ void vmm_unmap_page(void *vaddr) {
     ENTRY_DEL_ATTRIBUTE(*pdir_entry, PAGE_STRUCT_ENTRY_PRESENT);
 }
 
+void page_zero(void *vaddr){
+    if (!mem_has_sse2){
+        uint32_t dwords = PAGE_SIZE / 4;
+        asm volatile("rep stosl" : "+D" (vaddr), "+c" (dwords) : "a" (0) : "memory");
+        return;
+    }
+
+    uint8_t  save[64];
+    uint32_t flags = mem_sse2_begin(save);
+
+    /* non-temporal, a page that was just cleared is rarely read back right away */
+    asm volatile(
+        "pxor %%xmm0, %%xmm0\n"
+        "movl $64, %%ecx\n"
+        "1:\n"
+        "movntdq %%xmm0,   (%0)\n"
+        "movntdq %%xmm0, 16(%0)\n"
+        "movntdq %%xmm0, 32(%0)\n"
+        "movntdq %%xmm0, 48(%0)\n"
+        "addl $64, %0\n"
+        "decl %%ecx\n"
+        "jnz 1b\n"
+        "sfence\n"
+        : "+r" (vaddr) :: "ecx", "memory"
+    );
+
+    mem_sse2_end(save, flags);
+}
+
+void page_copy(void *dst, const void *src){
+    if (!mem_has_sse2){
+        uint32_t dwords = PAGE_SIZE / 4;
+        asm volatile("rep movsl" : "+D" (dst), "+S" (src), "+c" (dwords) :: "memory");
+        return;
+    }
+
+    uint8_t  save[64];
+    uint32_t flags = mem_sse2_begin(save);
+
+    asm volatile(
+        "movl $64, %%ecx\n"
+        "1:\n"
+        "movdqa   (%1), %%xmm0\n"
+        "movdqa 16(%1), %%xmm1\n"
+        "movdqa 32(%1), %%xmm2\n"
+        "movdqa 48(%1), %%xmm3\n"
+        "movntdq %%xmm0,   (%0)\n"
+        "movntdq %%xmm1, 16(%0)\n"
+        "movntdq %%xmm2, 32(%0)\n"
+        "movntdq %%xmm3, 48(%0)\n"
+        "addl $64, %0\n"
+        "addl $64, %1\n"
+        "decl %%ecx\n"
+        "jnz 1b\n"
+        "sfence\n"
+        : "+r" (dst), "+r" (src) :: "ecx", "memory"
+    );
+
+    mem_sse2_end(save, flags);
+}
+
+/**
+ * frames that were freed (dirty) wait for the timer to zero
+ *  them through the window, then sit in zeroed until a fault
+ *  or a new page table takes them
+ * the timer touches both lists, so everyone else does it with
+ *  interrupts off
+ */
+#define ZERO_POOL_SIZE 64
+/* nothing but the pool maps this page */
+#define ZERO_WINDOW    0xC03FE000
+
+static void    *zeroed[ZERO_POOL_SIZE],
+               *dirty[ZERO_POOL_SIZE];
+static uint32_t num_zeroed,
+                num_dirty;
+
+static uint32_t zero_pool_lock(){
+    uint32_t flags;
+    asm volatile("pushfl\n popl %0\n cli" : "=r" (flags) :: "memory");
+    return flags;
+}
+
+static void zero_pool_unlock(uint32_t flags){
+    if (flags & 0x200) asm volatile("sti" ::: "memory");
+}
+
+static void *zero_window_map(void *paddr){
+    ENTRY_SET_FRAME(higher_half_page_table.entries[PAGE_TABLE_INDEX(ZERO_WINDOW)], paddr);
+
+    /* not flush_tlb_entry, that turns interrupts back on */
+    asm volatile("invlpg (%0)" :: "r" (ZERO_WINDOW) : "memory");
+
+    return (void*) ZERO_WINDOW;
+}
+
+/* one frame a tick, the irq already has interrupts off */
+static void zero_pool_tick(uint64_t ticks){
+    if (!num_dirty || num_zeroed == ZERO_POOL_SIZE) return;
+
+    void *frame = dirty[--num_dirty];
+
+    page_zero(zero_window_map(frame));
+    zeroed[num_zeroed++] = frame;
+}
+
+static bool zero_pool_recycle(void *paddr){
+    uint32_t flags = zero_pool_lock();
+    bool res = num_dirty < ZERO_POOL_SIZE;
+
+    if (res) dirty[num_dirty++] = paddr;
+
+    zero_pool_unlock(flags);
+    return res;
+}
+
+void *alloc_zeroed_page(){
+    uint32_t flags = zero_pool_lock();
+    void *frame = num_zeroed ? zeroed[--num_zeroed] : NULL;
+
+    /* keep the timer supplied with something to zero */
+    if (num_dirty + num_zeroed < ZERO_POOL_SIZE){
+        void *spare = alloc_page();
+        if (spare) dirty[num_dirty++] = spare;
+    }
+
+    if (!frame){
+        frame = alloc_page();
+
+        if (frame)
+            page_zero(zero_window_map(frame));
+    }
+
+    zero_pool_unlock(flags);
+    return frame;
+}
+
 void *valloc_page(void *vaddr) {
     void *page = alloc_page();
     return vmm_map_page(page, vaddr ? vaddr : page, true, false);
@@ -157,8 +294,10 @@ void vfree_page(void *vaddr){
     void *paddr = virt_to_phys(vaddr);
 
     if (paddr){
-        free_page(paddr);
         vmm_unmap_page(vaddr);
+
+        if (!zero_pool_recycle(paddr))
+            free_page(paddr);
     }
 }
 void *valloc_big_page(void *vaddr) {
@@ -191,11 +330,32 @@ void VMM_init() {
 
     bitmap += 0xC0000000;
 
+    /**
+     * make the kernel respect read-only user pages too, so its
+     *  writes into copy-on-write mappings fault like user ones
+     */
+#ifndef __APPLE__
+    asm volatile("movl %%cr0, %%eax\n"
+                 "orl $0x10000, %%eax\n"
+                 "movl %%eax, %%cr0\n" ::
+                     : "eax");
+#endif
+
     flush_pd();
+
+    /* the timer fills the pool from here on */
+    uint32_t flags = zero_pool_lock();
+
+    while (num_dirty < ZERO_POOL_SIZE)
+        dirty[num_dirty++] = alloc_page();
+
+    zero_pool_unlock(flags);
+
+    PIT_add_tick_handler(zero_pool_tick);
 }
 
 void ISR_page_flt_handler(registers_t *regs) {
-    uint64_t fault_addr;
+    uint32_t fault_addr;
 
 #ifndef __APPLE__
     asm volatile("movl %%cr2, %0" : "=r"(fault_addr)::);
@@ -244,29 +404,18 @@ void copy_ptes(ptable_t *new_pt, ptable_t *old_pt, uint32_t start, uint32_t end)
 }
 
 void new_page_table(pdirectory_t *pd, uint32_t pdi, bool ring3){
-    void *new_pt = alloc_page();
+    void *new_pt = alloc_zeroed_page();
     ENTRY_SET_FRAME(pd->entries[pdi], new_pt);
     ENTRY_ADD_ATTRIBUTE(pd->entries[pdi], PAGE_STRUCT_ENTRY_PRESENT);
     ENTRY_ADD_ATTRIBUTE(pd->entries[pdi], PAGE_STRUCT_ENTRY_WRITEABLE);
 
     if (ring3)
         ENTRY_ADD_ATTRIBUTE(pd->entries[pdi], PAGE_STRUCT_ENTRY_USER_ACCESS);
-
-    /* page table will be mapped to 0xC03FF000 */
-    ptable_t *ptable = (ptable_t *)0xC03FF000;
-
-    /* used to map the page table into memory */
-    pt_entry_t *map_ptable_entry =
-        &higher_half_page_table.entries[PAGE_TABLE_INDEX(0xC03FF000)];
-
-    ENTRY_SET_FRAME(*map_ptable_entry, new_pt);
-    flush_tlb_entry(0xC03FF000);
-    memset(ptable, 0, sizeof(ptable_t));
 }
 
 pdirectory_t *new_page_directory(){
-    pdirectory_t *new_pd = valloc_page(NULL);
-    memset(new_pd, 0, sizeof *new_pd);
+    void *frame = alloc_zeroed_page();
+    pdirectory_t *new_pd = vmm_map_page(frame, frame, true, false);
 
     /* exe.c */
     extern t_Process *process_stack;
@@ -276,6 +425,10 @@ pdirectory_t *new_page_directory(){
         if (!(block->flags | UMM_BLOCK_FLAG_SHARED))
             continue;
 
+        /* page cache frames are only mapped through their own block */
+        if (block->file)
+            continue;
+
         uint32_t pti = PAGE_TABLE_INDEX((uint32_t)block->start),
                  pdi = PAGE_DIR_INDEX((uint32_t)block->start),
                  pti_end = PAGE_TABLE_INDEX((uint32_t)block->start + block->len),
@@ -350,7 +503,8 @@ void vmm_new_permissions(void *vaddr, bool write, bool ring3){
     pt_entry_t *map_ptable_entry =
         &higher_half_page_table.entries[PAGE_TABLE_INDEX(0xC03FF000)];
 
-    ENTRY_SET_ATTRIBUTE(*pdir_entry, PAGE_STRUCT_ENTRY_USER_ACCESS, ring3);
+    /* the value is masked with the attribute, so pass the bit itself */
+    ENTRY_SET_ATTRIBUTE(*pdir_entry, PAGE_STRUCT_ENTRY_USER_ACCESS, ring3 ? PAGE_STRUCT_ENTRY_USER_ACCESS : 0);
 
     /* page table not present */
     if (!ENTRY_GET_ATTRIBUTE(*pdir_entry, PAGE_STRUCT_ENTRY_PRESENT))
@@ -363,8 +517,40 @@ void vmm_new_permissions(void *vaddr, bool write, bool ring3){
     /* get the page table entry from the page table */
     pt_entry_t *pte = &ptable->entries[PAGE_TABLE_INDEX((uint32_t)vaddr)];
 
-    ENTRY_SET_ATTRIBUTE(*pte, PAGE_STRUCT_ENTRY_WRITEABLE, write);
-    ENTRY_SET_ATTRIBUTE(*pte, PAGE_STRUCT_ENTRY_USER_ACCESS, ring3);
+    ENTRY_SET_ATTRIBUTE(*pte, PAGE_STRUCT_ENTRY_WRITEABLE, write ? PAGE_STRUCT_ENTRY_WRITEABLE : 0);
+    ENTRY_SET_ATTRIBUTE(*pte, PAGE_STRUCT_ENTRY_USER_ACCESS, ring3 ? PAGE_STRUCT_ENTRY_USER_ACCESS : 0);
 
     flush_tlb_entry((vaddr_t)vaddr);
 }
+
+bool vmm_clear_dirty(void *vaddr){
+    pd_entry_t *pdir_entry =
+        &curr_page_directory->entries[PAGE_DIR_INDEX((uint32_t)vaddr)];
+
+    if (!ENTRY_GET_ATTRIBUTE(*pdir_entry, PAGE_STRUCT_ENTRY_PRESENT))
+        return false;
+
+    /* page table will be mapped to 0xC03FF000 */
+    ptable_t *ptable = (ptable_t *)0xC03FF000;
+
+    /* used to map the page table into memory */
+    pt_entry_t *map_ptable_entry =
+        &higher_half_page_table.entries[PAGE_TABLE_INDEX(0xC03FF000)];
+
+    ENTRY_SET_FRAME(*map_ptable_entry, PTE_FROM_PDIR(pdir_entry));
+    flush_tlb_entry(0xC03FF000);
+
+    pt_entry_t *pte = &ptable->entries[PAGE_TABLE_INDEX((uint32_t)vaddr)];
+
+    if (
+        !ENTRY_GET_ATTRIBUTE(*pte, PAGE_STRUCT_ENTRY_PRESENT) ||
+        !ENTRY_GET_ATTRIBUTE(*pte, PAGE_STRUCT_ENTRY_DIRTY)
+    )
+        return false;
+
+    ENTRY_DEL_ATTRIBUTE(*pte, PAGE_STRUCT_ENTRY_DIRTY);
+    /* the cpu only sets the bit again if the tlb entry is gone */
+    flush_tlb_entry((vaddr_t)vaddr);
+
+    return true;
+}
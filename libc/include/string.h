@@ -20,8 +20,38 @@ int strcmp(const char *, const char *);
 char *strchr(const char *str, int sep);
 char *strpbrk(const char *str, const char *set);
 
+/**
+ * picks the memcpy/memset variants for this cpu, call it
+ *  before anything else (the kernel also turns sse on here)
+ */
+void mem_init();
+
 #ifdef __cplusplus
 }
 #endif
 
 #endif
+
+#ifdef _STRING_H_INTERNAL
+
+/**
+ * copies/fills at least this long take the sse2 path, the
+ *  crossovers come from BENCH_mem, stosd holds up longer
+ *  since there are no loads to align
+ */
+#define MEM_SSE2_COPY_MIN 128
+#define MEM_SSE2_SET_MIN  1024
+
+extern bool mem_has_sse2;
+
+/* rep movsd/stosd with byte heads and tails, and 64 bytes per loop in xmm */
+void memcpy_movsd(void *dst, const void *src, size_t len);
+void memcpy_sse2(void *dst, const void *src, size_t len);
+void memset_stosd(void *ptr, uint8_t value, size_t size);
+void memset_sse2(void *ptr, uint8_t value, size_t size);
+
+/* saves xmm0-3 into save (64 bytes), returns what end needs back */
+uint32_t mem_sse2_begin(void *save);
+void     mem_sse2_end(void *save, uint32_t flags);
+
+#endif
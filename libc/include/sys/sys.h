@@ -19,6 +19,23 @@ typedef struct stat_t {
              flags;
 } stat_t;
 
+/**
+ * laid out like the kernel's t_VDSOTime
+ */
+typedef struct systime_t {
+    /* ms since boot */
+    uint64_t ticks;
+    uint16_t year;
+    uint8_t  seconds,
+             minutes,
+             hours,
+             weekday,
+             monthday,
+             month;
+    uint64_t tsc;
+    uint32_t tsc_per_tick;
+} systime_t;
+
 size_t read(int fd, void *buff, size_t count);
 size_t write(int fd, const void *buff, size_t count);
 int    open(const char *filename, uint8_t mode);
@@ -28,4 +45,7 @@ int    fstat(int fd, stat_t *statbuff);
 int    exec(const char *path, int argc, char **argv);
 void   exit(int status);
 
+/* reads the kernel's time page, no syscall */
+int    gettime(systime_t *out);
+
 #endif
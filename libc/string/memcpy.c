@@ -1,23 +1,75 @@
+#define _STRING_H_INTERNAL
 #include "../include/string.h"
 #include "../include/types.h"
 
-void* memcpy(void* restrict dst, const void* restrict src, size_t len){
-    while (len >= 4){
-        *(uint32_t*)dst = *(uint32_t*)src; 
-        len -= 4;
-
-        dst += 4;
-        src += 4;
+void memcpy_movsd(void *dst, const void *src, size_t len){
+    /* rep movs is slow to start, short copies don't make up for it */
+    if (len < 16){
+        while (len--)
+            *(uint8_t*)dst++ = *(uint8_t*)src++;
+        return;
     }
-    if (len >= 2){
-        *(uint16_t*)dst = *(uint16_t*)src;
-        len -= 2;
 
-        dst += 2;
-        src += 2;
+    size_t head   = -(uint32_t) dst & 3,
+           dwords = (len - head) / 4,
+           tail   = (len - head) % 4;
+
+    asm volatile(
+        "rep movsb\n"
+        "movl %3, %%ecx\n"
+        "rep movsl\n"
+        "movl %4, %%ecx\n"
+        "rep movsb\n"
+        : "+D" (dst), "+S" (src), "+c" (head)
+        : "r" (dwords), "r" (tail)
+        : "memory"
+    );
+}
+
+void memcpy_sse2(void *dst, const void *src, size_t len){
+    /* the stores are aligned, the loads take what they get */
+    size_t head = -(uint32_t) dst & 15;
+
+    memcpy_movsd(dst, src, head);
+    dst += head;
+    src += head;
+    len -= head;
+
+    size_t blocks = len / 64;
+
+    if (blocks){
+        uint8_t  save[64];
+        uint32_t flags = mem_sse2_begin(save);
+
+        asm volatile(
+            "1:\n"
+            "movdqu   (%1), %%xmm0\n"
+            "movdqu 16(%1), %%xmm1\n"
+            "movdqu 32(%1), %%xmm2\n"
+            "movdqu 48(%1), %%xmm3\n"
+            "movdqa %%xmm0,   (%0)\n"
+            "movdqa %%xmm1, 16(%0)\n"
+            "movdqa %%xmm2, 32(%0)\n"
+            "movdqa %%xmm3, 48(%0)\n"
+            "addl $64, %0\n"
+            "addl $64, %1\n"
+            "decl %2\n"
+            "jnz 1b\n"
+            : "+r" (dst), "+r" (src), "+r" (blocks)
+            :: "memory"
+        );
+
+        mem_sse2_end(save, flags);
     }
-    if (len)
-        *(uint8_t*)dst = *(uint8_t*)src;
+
+    memcpy_movsd(dst, src, len % 64);
+}
+
+void* memcpy(void* restrict dst, const void* restrict src, size_t len){
+    if (mem_has_sse2 && len >= MEM_SSE2_COPY_MIN)
+        memcpy_sse2(dst, src, len);
+    else
+        memcpy_movsd(dst, src, len);
 
     return dst;
 }
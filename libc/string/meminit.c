@@ -0,0 +1,70 @@
+#define _STRING_H_INTERNAL
+#include "../include/string.h"
+#include "../include/types.h"
+#include "../include/stdlib.h"
+
+bool mem_has_sse2;
+
+#define CPUID_FEAT_EDX_SSE  (1 << 25)
+#define CPUID_FEAT_EDX_SSE2 (1 << 26)
+
+void mem_init(){
+    uint32_t eax = 1, ebx, ecx, edx;
+    asm volatile("cpuid" : "+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+
+    if (!(edx & CPUID_FEAT_EDX_SSE) || !(edx & CPUID_FEAT_EDX_SSE2))
+        return;
+
+#ifdef __is_libk
+    /* nobody has turned sse on yet: clear EM, set MP, OSFXSR and OSXMMEXCPT */
+    asm volatile(
+        "movl %%cr0, %%eax\n"
+        "andl $~0x4, %%eax\n"
+        "orl  $0x2, %%eax\n"
+        "movl %%eax, %%cr0\n"
+        "movl %%cr4, %%eax\n"
+        "orl  $0x600, %%eax\n"
+        "movl %%eax, %%cr4\n"
+        ::: "eax"
+    );
+#endif
+
+    mem_has_sse2 = true;
+}
+
+/**
+ * the kernel doesn't save xmm registers for anyone, so the
+ *  sse2 paths put back the ones they use and keep interrupts
+ *  (which might copy too) out while they hold them
+ */
+uint32_t mem_sse2_begin(void *save){
+    uint32_t flags = 0;
+
+#ifdef __is_libk
+    asm volatile("pushfl\n popl %0\n cli" : "=r" (flags));
+#endif
+
+    asm volatile(
+        "movdqu %%xmm0,   (%0)\n"
+        "movdqu %%xmm1, 16(%0)\n"
+        "movdqu %%xmm2, 32(%0)\n"
+        "movdqu %%xmm3, 48(%0)\n"
+        :: "r" (save) : "memory"
+    );
+
+    return flags;
+}
+
+void mem_sse2_end(void *save, uint32_t flags){
+    asm volatile(
+        "movdqu   (%0), %%xmm0\n"
+        "movdqu 16(%0), %%xmm1\n"
+        "movdqu 32(%0), %%xmm2\n"
+        "movdqu 48(%0), %%xmm3\n"
+        :: "r" (save) : "memory"
+    );
+
+#ifdef __is_libk
+    if (flags & 0x200) asm volatile("sti");
+#endif
+}
@@ -2,46 +2,37 @@
 #include "../include/types.h"
 
 void* memmove(void* dst, const void* src, size_t size){
-    if (dst < src){
-        while (size >= 4){
-            *(uint32_t*)dst = *(uint32_t*)src;
-            size -= 4;
-            dst += 4;
-            src += 4;
-        }
+    /* a forward copy only breaks if dst starts inside src */
+    if (dst <= src || dst >= src + size)
+        return memcpy(dst, src, size);
 
-        if (size >= 2){
-            *(uint16_t*)dst = *(uint16_t*)src;
-            size -= 2;
-            dst += 2;
-            src += 2;
-        }
+    size_t dwords = size / 4,
+           bytes  = size % 4;
 
-        if (size){
-            *(uint8_t*)dst = *(uint8_t*)(src);
-        }
-    }
-    else {
-        dst += size;
-        src += size;
+    void       *d = dst + size - 1;
+    const void *s = src + size - 1;
 
-        while (size >= 4){
-            *(uint32_t*)dst = *(uint32_t*)src;
-            size -= 4;
-            dst -= 4;
-            src -= 4;
-        }
+    /**
+     * backwards from the last byte, the odd bytes first then
+     *  dwords, DF is put back by popfl before anything else
+     *  (an interrupt in the kernel) can see it
+     */
+    asm volatile(
+        "pushfl\n"
+#ifdef __is_libk
+        "cli\n"
+#endif
+        "std\n"
+        "rep movsb\n"
+        "subl $3, %%edi\n"
+        "subl $3, %%esi\n"
+        "movl %3, %%ecx\n"
+        "rep movsl\n"
+        "popfl\n"
+        : "+D" (d), "+S" (s), "+c" (bytes)
+        : "r" (dwords)
+        : "memory"
+    );
 
-        if (size >= 2){
-            *(uint16_t*)dst = *(uint16_t*)src;
-            size -= 2;
-            dst -= 2;
-            src -= 2;
-        }
-
-        if (size){
-            *(uint8_t*)dst = *(uint8_t*)(src);
-        }
-    }
     return dst;
-}
\ No newline at end of file
+}
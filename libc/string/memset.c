@@ -1,9 +1,73 @@
+#define _STRING_H_INTERNAL
 #include "../include/string.h"
 #include "../include/types.h"
 
+void memset_stosd(void *ptr, uint8_t value, size_t size){
+    if (size < 16){
+        while (size--)
+            *(uint8_t*)ptr++ = value;
+        return;
+    }
+
+    uint32_t pattern = value * 0x01010101U;
+
+    size_t head   = -(uint32_t) ptr & 3,
+           dwords = (size - head) / 4,
+           tail   = (size - head) % 4;
+
+    asm volatile(
+        "rep stosb\n"
+        "movl %3, %%ecx\n"
+        "rep stosl\n"
+        "movl %4, %%ecx\n"
+        "rep stosb\n"
+        : "+D" (ptr), "+c" (head)
+        : "a" (pattern), "r" (dwords), "r" (tail)
+        : "memory"
+    );
+}
+
+void memset_sse2(void *ptr, uint8_t value, size_t size){
+    size_t head = -(uint32_t) ptr & 15;
+
+    memset_stosd(ptr, value, head);
+    ptr  += head;
+    size -= head;
+
+    size_t blocks = size / 64;
+
+    if (blocks){
+        uint32_t pattern[4] = {[0 ... 3] = value * 0x01010101U};
+
+        uint8_t  save[64];
+        uint32_t flags = mem_sse2_begin(save);
+
+        asm volatile(
+            "movdqu (%2), %%xmm0\n"
+            "1:\n"
+            "movdqa %%xmm0,   (%0)\n"
+            "movdqa %%xmm0, 16(%0)\n"
+            "movdqa %%xmm0, 32(%0)\n"
+            "movdqa %%xmm0, 48(%0)\n"
+            "addl $64, %0\n"
+            "decl %1\n"
+            "jnz 1b\n"
+            : "+r" (ptr), "+r" (blocks)
+            : "r" (pattern)
+            : "memory"
+        );
+
+        mem_sse2_end(save, flags);
+    }
+
+    memset_stosd(ptr, value, size % 64);
+}
+
 void* memset(void* ptr, int value, size_t size){
-    for (size_t i = 0; i < size; ++i)
-        ((uint8_t*)ptr)[i] = value;
+    if (mem_has_sse2 && size >= MEM_SSE2_SET_MIN)
+        memset_sse2(ptr, value, size);
+    else
+        memset_stosd(ptr, value, size);
 
     return ptr;
-}
\ No newline at end of file
+}
@@ -1,5 +1,6 @@
 #include <sys/sys.h>
 #include <kernel/sys.h>
+#include <kernel/vdso.h>
 
 size_t read(int fd, void *buff, size_t count){
 #ifdef __is_libk
@@ -65,4 +66,19 @@ void exit(int status){
 #endif
 }
 
+int gettime(systime_t *out){
+#ifdef __is_libk
+    const t_VDSOPage *page = (void*) VDSO_KVADDR;
+#else
+    const t_VDSOPage *page = (void*) VDSO_VADDR;
+#endif
+    uint32_t seq;
 
+    do {
+        seq = __atomic_load_n(&page->seq, __ATOMIC_ACQUIRE);
+        *out = *(const systime_t*) &page->data;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (seq & 1 || seq != page->seq);
+
+    return 0;
+}